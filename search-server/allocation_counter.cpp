@@ -0,0 +1,79 @@
+#include "allocation_counter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// перед каждым блоком хранится его размер, что позволяет отслеживать занятую и пиковую память
+static std::atomic<size_t> allocation_count = 0;
+static std::atomic<size_t> allocated_bytes = 0;
+static std::atomic<size_t> peak_allocated_bytes = 0;
+
+static void* CountedAllocate(std::size_t size, std::size_t alignment) {
+    ++allocation_count;
+    // заголовок занимает целое число выравниваний, чтобы сам блок остался выровненным
+    const size_t header_size = std::max(alignment, alignof(std::max_align_t));
+    const size_t block_size = (size + header_size + alignment - 1) / alignment * alignment;
+    void* block = alignment > alignof(std::max_align_t)
+        ? std::aligned_alloc(alignment, block_size)
+        : std::malloc(block_size);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t*>(block) = size;
+    const size_t current_bytes = allocated_bytes += size;
+    size_t peak_bytes = peak_allocated_bytes;
+    while (current_bytes > peak_bytes && !peak_allocated_bytes.compare_exchange_weak(peak_bytes, current_bytes)) {
+    }
+    return static_cast<char*>(block) + header_size;
+}
+
+static void CountedDeallocate(void* ptr, std::size_t alignment) noexcept {
+    if (!ptr) {
+        return;
+    }
+    void* block = static_cast<char*>(ptr) - std::max(alignment, alignof(std::max_align_t));
+    allocated_bytes -= *static_cast<size_t*>(block);
+    std::free(block);
+}
+
+void* operator new(std::size_t size) {
+    return CountedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return CountedAllocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+    CountedDeallocate(ptr, alignof(std::max_align_t));
+}
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept {
+    CountedDeallocate(ptr, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    CountedDeallocate(ptr, alignof(std::max_align_t));
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    CountedDeallocate(ptr, static_cast<size_t>(alignment));
+}
+
+size_t GetAllocationCount() {
+    return allocation_count;
+}
+
+size_t GetAllocatedBytes() {
+    return allocated_bytes;
+}
+
+size_t GetPeakAllocatedBytes() {
+    return peak_allocated_bytes;
+}
+
+void ResetPeakAllocatedBytes() {
+    peak_allocated_bytes = allocated_bytes.load();
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+
+// модуль заменяет глобальные operator new/delete и ведёт счётчики выделений динамической памяти
+// для тестов аллокаций и бенчмарков; подключение модуля к сборке включает подсчёт во всей программе
+
+// число вызовов operator new с начала работы программы
+size_t GetAllocationCount();
+
+// объём занятой в текущий момент динамической памяти, в байтах
+size_t GetAllocatedBytes();
+
+// максимальный объём занятой памяти с момента последнего вызова ResetPeakAllocatedBytes
+size_t GetPeakAllocatedBytes();
+
+void ResetPeakAllocatedBytes();
\ No newline at end of file
@@ -0,0 +1,545 @@
+// Бенчмарк поискового сервера на синтетической коллекции с ципфовским распределением слов.
+// Отдельная цель сборки: benchmark/*.cpp и все модули сервера, кроме main.cpp.
+// Результаты выводятся в stdout в формате JSON Lines, по одной записи на операцию и размер коллекции:
+//   {"benchmark": ..., "documents": ..., "operations": ..., "ns_per_op": ..., "ops_per_sec": ...,
+//    "allocations_per_op": ..., "peak_bytes": ..., "checksum": ...}
+// Параметры командной строки: --seed=N, --sizes=N1,N2,..., --queries=N, --metrics (строка {"stages": ..., "counters": ...}
+// с гистограммами этапов и счётчиками после замеров каждого размера коллекции)
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "../allocation_counter.h"
+#include "../impact_index.h"
+#include "../process_queries.h"
+#include "../remove_duplicates.h"
+#include "../search_server.h"
+#include "legacy_concurrent_map.h"
+#include "zipf_corpus.h"
+
+using namespace std::literals;
+
+struct BenchmarkOptions {
+    uint64_t seed = 42;
+    std::vector<size_t> corpus_sizes = { 1'000, 10'000, 100'000 };
+    size_t query_count = 1'000;
+    size_t max_query_word_count = 5;
+    double minus_probability = 0.2;
+    // число документов, удаляемых RemoveDocument и дублируемых для RemoveDuplicates
+    size_t removed_document_count = 100;
+    // после замеров каждого размера корпуса выводится строка с гистограммами этапов и счётчиками
+    bool print_metrics = false;
+};
+
+// замер операции, выполняющей operation_count действий; operation возвращает контрольную сумму,
+// которая выводится вместе с результатом, чтобы компилятор не мог выбросить вычисления
+template <typename Operation>
+void Measure(std::string_view name, size_t document_count, size_t operation_count, Operation operation) {
+    const size_t allocations_before = GetAllocationCount();
+    const size_t bytes_before = GetAllocatedBytes();
+    ResetPeakAllocatedBytes();
+
+    const auto start_time = std::chrono::steady_clock::now();
+    const double checksum = operation();
+    const auto duration = std::chrono::steady_clock::now() - start_time;
+
+    const double ns = std::chrono::duration<double, std::nano>(duration).count();
+    const double ns_per_op = operation_count == 0 ? 0.0 : ns / operation_count;
+    const double ops_per_sec = ns == 0.0 ? 0.0 : operation_count * 1e9 / ns;
+    const double allocations_per_op = operation_count == 0
+        ? 0.0
+        : (GetAllocationCount() - allocations_before) * 1.0 / operation_count;
+    const size_t peak_bytes = GetPeakAllocatedBytes() - bytes_before;
+
+    std::cout << "{\"benchmark\": \""s << name << "\", "s
+              << "\"documents\": "s << document_count << ", "s
+              << "\"operations\": "s << operation_count << ", "s
+              << "\"ns_per_op\": "s << ns_per_op << ", "s
+              << "\"ops_per_sec\": "s << ops_per_sec << ", "s
+              << "\"allocations_per_op\": "s << allocations_per_op << ", "s
+              << "\"peak_bytes\": "s << peak_bytes << ", "s
+              << "\"checksum\": "s << checksum << "}"s << std::endl;
+}
+
+// резидентная память процесса по /proc/self/statm; вне Linux - 0
+size_t GetResidentBytes() {
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    statm >> total_pages >> resident_pages;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+// возвращает системе свободную память кучи, оставшуюся от предыдущих замеров, чтобы прирост
+// резидентной памяти считался от неё
+void TrimHeap() {
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
+template <typename ExecutionPolicy>
+double RunQueries(const SearchServer& search_server, const std::vector<std::string>& queries, ExecutionPolicy&& policy) {
+    double total_relevance = 0.0;
+    for (const std::string& query : queries) {
+        for (const Document& document : search_server.FindTopDocuments(policy, query)) {
+            total_relevance += document.relevance;
+        }
+    }
+    return total_relevance;
+}
+
+// прибавления к значениям словаря из нескольких потоков, каждый поток берёт свою долю ключей;
+// возвращает сумму значений словаря после обхода
+template <typename Map, typename KeyType, typename Add>
+double RunConcurrentAdds(Map& map, const std::vector<KeyType>& keys, size_t thread_count, Add add) {
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            for (size_t i = t; i < keys.size(); i += thread_count) {
+                add(map, keys[i]);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double total = 0.0;
+    for (const auto& [key, value] : map.BuildOrdinaryMap()) {
+        total += value;
+    }
+    return total;
+}
+
+// конкуренция за ConcurrentMap при накоплении релевантности: прежняя реализация со std::map под мьютексом
+// в каждом сегменте против хеш-таблицы с атомарными прибавлениями, с целыми и строковыми ключами
+void RunConcurrentMapBenchmarks(ZipfCorpusGenerator& generator, size_t document_count, size_t key_count) {
+    const size_t thread_count = std::max<size_t>(4, std::thread::hardware_concurrency());
+    const size_t segment_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::vector<int> keys(key_count);
+    for (int& key : keys) {
+        key = static_cast<int>(generator.GenerateIndex(document_count));
+    }
+    std::vector<std::string> string_keys;
+    string_keys.reserve(key_count);
+    for (int key : keys) {
+        string_keys.push_back("document-"s + std::to_string(key));
+    }
+
+    Measure("ConcurrentMap/legacy/add"sv, document_count, key_count, [&] {
+        LegacyConcurrentMap<int, double> map(segment_count);
+        return RunConcurrentAdds(map, keys, thread_count, [](auto& map, int key) { map[key].ref_to_value += 1.0; });
+    });
+    Measure("ConcurrentMap/fetch-add"sv, document_count, key_count, [&] {
+        ConcurrentMap<int, double> map(segment_count);
+        return RunConcurrentAdds(map, keys, thread_count, [](auto& map, int key) { map.FetchAdd(key, 1.0); });
+    });
+    Measure("ConcurrentMap/fetch-add/presized"sv, document_count, key_count, [&] {
+        ConcurrentMap<int, double> map(segment_count, document_count);
+        return RunConcurrentAdds(map, keys, thread_count, [](auto& map, int key) { map.FetchAdd(key, 1.0); });
+    });
+    Measure("ConcurrentMap/string-keys/fetch-add"sv, document_count, key_count, [&] {
+        ConcurrentMap<std::string, double> map(segment_count, document_count);
+        return RunConcurrentAdds(map, string_keys, thread_count,
+            [](auto& map, const std::string& key) { map.FetchAdd(key, 1.0); });
+    });
+}
+
+// доля документов точного топ-5, найденных снимком с квантованными вкладами, наибольшее отклонение
+// релевантности от точной и объём памяти снимка в сравнении со списками документов сервера
+void PrintImpactIndexDeviation(const SearchServer& search_server, const ImpactIndex& impact_index,
+                               const std::vector<std::string>& queries) {
+    size_t exact_count = 0;
+    size_t found_count = 0;
+    double max_relevance_error = 0.0;
+    for (const std::string& query : queries) {
+        const auto exact = search_server.FindTopDocuments(query);
+        const auto approximate = impact_index.FindTopDocuments(query);
+        exact_count += exact.size();
+        for (const Document& document : approximate) {
+            const auto it = std::find_if(exact.begin(), exact.end(),
+                [&document](const Document& exact_document) { return exact_document.id == document.id; });
+            if (it != exact.end()) {
+                ++found_count;
+                max_relevance_error = std::max(max_relevance_error, std::abs(it->relevance - document.relevance));
+            }
+        }
+    }
+    std::cout << "{\"benchmark\": \"ImpactIndex/Deviation\", "s
+              << "\"documents\": "s << search_server.GetDocumentCount() << ", "s
+              << "\"recall_at_5\": "s << (exact_count == 0 ? 1.0 : found_count * 1.0 / exact_count) << ", "s
+              << "\"max_relevance_error\": "s << max_relevance_error << ", "s
+              << "\"quantization_step\": "s << impact_index.GetQuantizationStep() << ", "s
+              << "\"index_bytes\": "s << impact_index.GetMemoryBytes() << ", "s
+              << "\"postings_bytes\": "s << search_server.GetIndexStats().postings_bytes << "}"s << std::endl;
+}
+
+// построение и уничтожение индекса с памятью из заданного ресурса; пустой owned_resource - куча.
+// Кроме выделений из кучи выводится прирост резидентной памяти процесса после построения
+// и остаток прироста после уничтожения: память, которую аллокатор не вернул системе из-за фрагментации
+void MeasureIndexMemoryResource(std::string_view name, const std::string& stop_words, const std::vector<std::string>& documents,
+                                std::unique_ptr<std::pmr::memory_resource> owned_resource) {
+    std::pmr::memory_resource* resource = owned_resource ? owned_resource.get() : std::pmr::new_delete_resource();
+    const size_t allocations_before = GetAllocationCount();
+    const size_t bytes_before = GetAllocatedBytes();
+    TrimHeap();
+    const size_t resident_before = GetResidentBytes();
+    ResetPeakAllocatedBytes();
+
+    const auto build_start = std::chrono::steady_clock::now();
+    auto search_server = std::make_unique<SearchServer>(stop_words, resource);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server->AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    const auto build_duration = std::chrono::steady_clock::now() - build_start;
+    const size_t allocation_count = GetAllocationCount() - allocations_before;
+    const size_t heap_bytes = GetAllocatedBytes() - bytes_before;
+    const size_t peak_heap_bytes = GetPeakAllocatedBytes() - bytes_before;
+    const size_t resident_after_build = GetResidentBytes();
+
+    const auto teardown_start = std::chrono::steady_clock::now();
+    search_server.reset();
+    owned_resource.reset();
+    const auto teardown_duration = std::chrono::steady_clock::now() - teardown_start;
+    const size_t resident_after_teardown = GetResidentBytes();
+
+    const auto growth = [resident_before](size_t resident) {
+        return resident > resident_before ? resident - resident_before : 0;
+    };
+    std::cout << "{\"benchmark\": \""s << name << "\", "s
+              << "\"documents\": "s << documents.size() << ", "s
+              << "\"build_ns\": "s << std::chrono::duration<double, std::nano>(build_duration).count() << ", "s
+              << "\"teardown_ns\": "s << std::chrono::duration<double, std::nano>(teardown_duration).count() << ", "s
+              << "\"heap_allocations\": "s << allocation_count << ", "s
+              << "\"heap_bytes\": "s << heap_bytes << ", "s
+              << "\"peak_heap_bytes\": "s << peak_heap_bytes << ", "s
+              << "\"rss_growth_bytes\": "s << growth(resident_after_build) << ", "s
+              << "\"rss_retained_bytes\": "s << growth(resident_after_teardown) << "}"s << std::endl;
+}
+
+// индекс в куче, в пуле и в монотонной арене std::pmr; резидентная память общая для процесса,
+// поэтому ресурсы замеряются в одном и том же порядке
+void RunMemoryResourceBenchmarks(const std::string& stop_words, const std::vector<std::string>& documents) {
+    MeasureIndexMemoryResource("IndexMemoryResource/heap"sv, stop_words, documents, nullptr);
+    MeasureIndexMemoryResource("IndexMemoryResource/pool"sv, stop_words, documents,
+        std::make_unique<std::pmr::unsynchronized_pool_resource>());
+    MeasureIndexMemoryResource("IndexMemoryResource/monotonic"sv, stop_words, documents,
+        std::make_unique<std::pmr::monotonic_buffer_resource>());
+}
+
+void RunBenchmarks(const BenchmarkOptions& options, size_t document_count) {
+    CorpusOptions corpus_options;
+    corpus_options.seed = options.seed;
+    ZipfCorpusGenerator generator(corpus_options);
+    const auto documents = generator.GenerateDocuments(document_count);
+    const auto queries = generator.GenerateQueries(options.query_count, options.max_query_word_count, 0.0);
+    const auto minus_queries = generator.GenerateQueries(options.query_count, options.max_query_word_count, options.minus_probability);
+    std::vector<int> match_ids(options.query_count);
+    for (int& document_id : match_ids) {
+        document_id = static_cast<int>(generator.GenerateIndex(document_count));
+    }
+
+    RunConcurrentMapBenchmarks(generator, document_count, options.query_count * 100);
+
+    SearchServer search_server(generator.GetStopWords());
+    Measure("AddDocument"sv, document_count, document_count, [&] {
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        return static_cast<double>(search_server.GetDocumentCount());
+    });
+
+    Measure("FindTopDocuments/seq"sv, document_count, queries.size(), [&] {
+        return RunQueries(search_server, queries, std::execution::seq);
+    });
+    Measure("FindTopDocuments/par"sv, document_count, queries.size(), [&] {
+        return RunQueries(search_server, queries, std::execution::par);
+    });
+    // те же запросы с бюджетом на число проверенных записей списков документов
+    SearchBudget budget;
+    budget.max_postings = 1000;
+    Measure("FindTopDocumentsWithinBudget/postings=1000"sv, document_count, queries.size(), [&] {
+        double total_relevance = 0.0;
+        for (const std::string& query : queries) {
+            for (const Document& document : search_server.FindTopDocumentsWithinBudget(query, budget).documents) {
+                total_relevance += document.relevance;
+            }
+        }
+        return total_relevance;
+    });
+    // те же запросы, в которых все слова обязательные
+    std::vector<std::string> required_queries;
+    for (const std::string& query : queries) {
+        std::string required_query = "+"s + query;
+        for (size_t pos = required_query.find(' '); pos != required_query.npos; pos = required_query.find(' ', pos + 2)) {
+            required_query.insert(pos + 1, "+"s);
+        }
+        required_queries.push_back(std::move(required_query));
+    }
+    Measure("FindTopDocuments/seq/required"sv, document_count, required_queries.size(), [&] {
+        return RunQueries(search_server, required_queries, std::execution::seq);
+    });
+    // первые слова тех же запросов: такие запросы выполняются по спискам лидеров слов
+    std::vector<std::string> single_word_queries;
+    for (const std::string& query : queries) {
+        single_word_queries.push_back(query.substr(0, query.find(' ')));
+    }
+    Measure("FindTopDocuments/seq/single-word"sv, document_count, single_word_queries.size(), [&] {
+        return RunQueries(search_server, single_word_queries, std::execution::seq);
+    });
+    // те же слова с пропущенной буквой: запрос выполняется по исправленным словам
+    std::vector<std::string> typo_queries;
+    for (const std::string& query : single_word_queries) {
+        typo_queries.push_back(query.size() < 4 ? query : query.substr(0, query.size() / 2) + query.substr(query.size() / 2 + 1));
+    }
+    Measure("FindTopDocuments/seq/typos"sv, document_count, typo_queries.size(), [&] {
+        return RunQueries(search_server, typo_queries, std::execution::seq);
+    });
+    Measure("FindTopDocuments/seq/minus"sv, document_count, minus_queries.size(), [&] {
+        return RunQueries(search_server, minus_queries, std::execution::seq);
+    });
+    Measure("FindTopDocuments/par/minus"sv, document_count, minus_queries.size(), [&] {
+        return RunQueries(search_server, minus_queries, std::execution::par);
+    });
+    QueryContext context;
+    Measure("FindTopDocuments/context/minus"sv, document_count, minus_queries.size(), [&] {
+        double total_relevance = 0.0;
+        for (const std::string& query : minus_queries) {
+            for (const Document& document : search_server.FindTopDocuments(context, query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        return total_relevance;
+    });
+    // те же запросы с ранжированием BM25: длина документа читается на каждую запись списка документов
+    Measure("FindTopDocuments/context/bm25/minus"sv, document_count, minus_queries.size(), [&] {
+        double total_relevance = 0.0;
+        for (const std::string& query : minus_queries) {
+            for (const Document& document : search_server.FindTopDocuments(context, query,
+                     DocumentFilter::ByStatus(DocumentStatus::ACTUAL), Bm25Scoring())) {
+                total_relevance += document.relevance;
+            }
+        }
+        return total_relevance;
+    });
+    // те же запросы, подготовленные заранее: без разбора и поиска слов в словаре
+    std::vector<PreparedQuery> prepared_queries;
+    for (const std::string& query : minus_queries) {
+        prepared_queries.push_back(search_server.PrepareQuery(query));
+    }
+    Measure("FindTopDocuments/context/prepared/minus"sv, document_count, prepared_queries.size(), [&] {
+        double total_relevance = 0.0;
+        for (PreparedQuery& query : prepared_queries) {
+            for (const Document& document : search_server.FindTopDocuments(context, query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        return total_relevance;
+    });
+
+    // снимок с квантованными вкладами: построение, запросы и отклонение выдачи от точной
+    std::unique_ptr<ImpactIndex> impact_index;
+    Measure("ImpactIndex/Build"sv, document_count, 1, [&] {
+        impact_index = std::make_unique<ImpactIndex>(search_server);
+        return static_cast<double>(impact_index->GetMemoryBytes());
+    });
+    Measure("ImpactIndex/FindTopDocuments/context/minus"sv, document_count, minus_queries.size(), [&] {
+        double total_relevance = 0.0;
+        for (const std::string& query : minus_queries) {
+            for (const Document& document : impact_index->FindTopDocuments(context, query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        return total_relevance;
+    });
+    PrintImpactIndexDeviation(search_server, *impact_index, minus_queries);
+
+    // хранилище исходных текстов: добавление, фрагменты случайных документов со словами запросов и степень сжатия
+    DocumentStore document_store;
+    Measure("DocumentStore/Add"sv, document_count, document_count, [&] {
+        for (size_t i = 0; i < documents.size(); ++i) {
+            document_store.Add(static_cast<int>(i), documents[i]);
+        }
+        return static_cast<double>(document_store.GetMemoryBytes());
+    });
+    Measure("DocumentStore/GetSnippets"sv, document_count, queries.size(), [&] {
+        size_t total_length = 0;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            for (const std::string& snippet : document_store.GetSnippets(match_ids[i], SplitIntoWords(queries[i]))) {
+                total_length += snippet.size();
+            }
+        }
+        return static_cast<double>(total_length);
+    });
+    std::cout << "{\"benchmark\": \"DocumentStore/Compression\", "s
+              << "\"documents\": "s << document_count << ", "s
+              << "\"text_bytes\": "s << document_store.GetTextBytes() << ", "s
+              << "\"store_bytes\": "s << document_store.GetMemoryBytes() << ", "s
+              << "\"ratio\": "s << document_store.GetMemoryBytes() * 1.0 / document_store.GetTextBytes() << "}"s << std::endl;
+
+    // позиционный индекс: добавление документов с ним и фразы из пар соседних слов случайных документов
+    // в сравнении с теми же словами как обязательными (пересечение списков без проверки позиций)
+    SearchServer phrase_server(generator.GetStopWords());
+    phrase_server.EnablePositionalIndex();
+    Measure("AddDocument/positional"sv, document_count, document_count, [&] {
+        for (size_t i = 0; i < documents.size(); ++i) {
+            phrase_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        return static_cast<double>(phrase_server.GetDocumentCount());
+    });
+    std::vector<std::string> phrase_queries;
+    std::vector<std::string> conjunctive_queries;
+    for (int document_id : match_ids) {
+        const auto words = SplitIntoWords(documents[document_id]);
+        if (words.size() < 2) {
+            continue;
+        }
+        const size_t start = phrase_queries.size() % (words.size() - 1);
+        const std::string first_word(words[start]);
+        const std::string second_word(words[start + 1]);
+        phrase_queries.push_back("\""s + first_word + " "s + second_word + "\""s);
+        conjunctive_queries.push_back("+"s + first_word + " +"s + second_word);
+    }
+    const auto run_context_queries = [&](const std::vector<std::string>& context_queries) {
+        double total_relevance = 0.0;
+        for (const std::string& query : context_queries) {
+            for (const Document& document : phrase_server.FindTopDocuments(context, query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        return total_relevance;
+    };
+    Measure("FindTopDocuments/context/required-pairs"sv, document_count, conjunctive_queries.size(), [&] {
+        return run_context_queries(conjunctive_queries);
+    });
+    Measure("FindTopDocuments/context/phrases"sv, document_count, phrase_queries.size(), [&] {
+        return run_context_queries(phrase_queries);
+    });
+    const IndexStats phrase_stats = phrase_server.GetIndexStats();
+    std::cout << "{\"benchmark\": \"PositionalIndex/Memory\", "s
+              << "\"documents\": "s << document_count << ", "s
+              << "\"positional_index_bytes\": "s << phrase_stats.positional_index_bytes << ", "s
+              << "\"postings_bytes\": "s << phrase_stats.postings_bytes << "}"s << std::endl;
+
+    Measure("MatchDocument/seq"sv, document_count, minus_queries.size(), [&] {
+        size_t matched_words = 0;
+        for (size_t i = 0; i < minus_queries.size(); ++i) {
+            matched_words += std::get<0>(search_server.MatchDocument(minus_queries[i], match_ids[i])).size();
+        }
+        return static_cast<double>(matched_words);
+    });
+    Measure("MatchDocument/par"sv, document_count, minus_queries.size(), [&] {
+        size_t matched_words = 0;
+        for (size_t i = 0; i < minus_queries.size(); ++i) {
+            matched_words += std::get<0>(search_server.MatchDocument(std::execution::par, minus_queries[i], match_ids[i])).size();
+        }
+        return static_cast<double>(matched_words);
+    });
+
+    Measure("ProcessQueries"sv, document_count, minus_queries.size(), [&] {
+        double total_relevance = 0.0;
+        for (const auto& documents_of_query : ProcessQueries(search_server, minus_queries)) {
+            for (const Document& document : documents_of_query) {
+                total_relevance += document.relevance;
+            }
+        }
+        return total_relevance;
+    });
+    Measure("ProcessQueriesBatched"sv, document_count, minus_queries.size(), [&] {
+        double total_relevance = 0.0;
+        for (const auto& documents_of_query : ProcessQueriesBatched(search_server, minus_queries)) {
+            for (const Document& document : documents_of_query) {
+                total_relevance += document.relevance;
+            }
+        }
+        return total_relevance;
+    });
+
+    // удаляемые документы - первые removed_count id; для RemoveDuplicates их копии добавляются с новыми id
+    const size_t removed_count = std::min(options.removed_document_count, document_count / 2);
+    {
+        SearchServer server_with_duplicates = search_server;
+        for (size_t i = 0; i < removed_count; ++i) {
+            server_with_duplicates.AddDocument(static_cast<int>(document_count + i), documents[i], DocumentStatus::ACTUAL, { 1 });
+        }
+        std::ostringstream removed_log;
+        Measure("RemoveDuplicates"sv, document_count, 1, [&] {
+            RemoveDuplicates(server_with_duplicates, removed_log);
+            return static_cast<double>(server_with_duplicates.GetDocumentCount());
+        });
+    }
+    Measure("RemoveDocument/seq"sv, document_count, removed_count, [&] {
+        for (size_t i = 0; i < removed_count; ++i) {
+            search_server.RemoveDocument(static_cast<int>(i));
+        }
+        return static_cast<double>(search_server.GetDocumentCount());
+    });
+    Measure("RemoveDocument/par"sv, document_count, removed_count, [&] {
+        for (size_t i = removed_count; i < 2 * removed_count; ++i) {
+            search_server.RemoveDocument(std::execution::par, static_cast<int>(i));
+        }
+        return static_cast<double>(search_server.GetDocumentCount());
+    });
+
+    RunMemoryResourceBenchmarks(generator.GetStopWords(), documents);
+}
+
+BenchmarkOptions ParseOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument = argv[i];
+        const auto separator = argument.find('=');
+        const std::string_view key = argument.substr(0, separator);
+        const std::string value(separator == argument.npos ? ""sv : argument.substr(separator + 1));
+        if (key == "--seed"sv) {
+            options.seed = std::stoull(value);
+        } else if (key == "--queries"sv) {
+            options.query_count = std::stoull(value);
+        } else if (key == "--metrics"sv) {
+            options.print_metrics = true;
+        } else if (key == "--sizes"sv) {
+            options.corpus_sizes.clear();
+            std::istringstream sizes(value);
+            for (std::string size; std::getline(sizes, size, ',');) {
+                options.corpus_sizes.push_back(std::stoull(size));
+            }
+        } else {
+            throw std::invalid_argument("Unknown option: "s + std::string(argument));
+        }
+    }
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    const BenchmarkOptions options = ParseOptions(argc, argv);
+    for (const size_t document_count : options.corpus_sizes) {
+        ResetMetrics();
+        RunBenchmarks(options, document_count);
+        if (options.print_metrics) {
+            PrintMetricsJson(CollectMetrics());
+        }
+    }
+    return 0;
+}
\ No newline at end of file
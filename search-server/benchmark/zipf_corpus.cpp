@@ -0,0 +1,109 @@
+#include "zipf_corpus.h"
+
+#include <algorithm>
+#include <cmath>
+
+ZipfCorpusGenerator::ZipfCorpusGenerator(const CorpusOptions& options)
+    : options_(options)
+    , generator_(options.seed)
+    , cumulative_probabilities_(options.vocabulary_size) {
+    double sum = 0.0;
+    for (size_t rank = 0; rank < options_.vocabulary_size; ++rank) {
+        sum += 1.0 / std::pow(rank + 1.0, options_.zipf_exponent);
+        cumulative_probabilities_[rank] = sum;
+    }
+    for (double& probability : cumulative_probabilities_) {
+        probability /= sum;
+    }
+}
+
+std::string ZipfCorpusGenerator::GetWord(size_t rank) {
+    // биективная запись ранга в 26-ричной системе: a, b, ..., z, aa, ab, ...
+    std::string word;
+    ++rank;
+    while (rank > 0) {
+        --rank;
+        word.push_back(static_cast<char>('a' + rank % 26));
+        rank /= 26;
+    }
+    return word;
+}
+
+std::string ZipfCorpusGenerator::GetStopWords() const {
+    std::string stop_words;
+    for (size_t rank = 0; rank < options_.stop_word_count; ++rank) {
+        if (!stop_words.empty()) {
+            stop_words.push_back(' ');
+        }
+        stop_words += GetWord(rank);
+    }
+    return stop_words;
+}
+
+std::string ZipfCorpusGenerator::GenerateDocument() {
+    const double length = options_.median_document_length * std::exp(options_.document_length_sigma * GenerateStandardNormal());
+    const size_t word_count = std::clamp<size_t>(static_cast<size_t>(length), 1, options_.max_document_length);
+    std::string document;
+    for (size_t i = 0; i < word_count; ++i) {
+        if (!document.empty()) {
+            document.push_back(' ');
+        }
+        document += GetWord(GenerateWordRank());
+    }
+    return document;
+}
+
+std::vector<std::string> ZipfCorpusGenerator::GenerateDocuments(size_t document_count) {
+    std::vector<std::string> documents;
+    documents.reserve(document_count);
+    for (size_t i = 0; i < document_count; ++i) {
+        documents.push_back(GenerateDocument());
+    }
+    return documents;
+}
+
+std::string ZipfCorpusGenerator::GenerateQuery(size_t word_count, double minus_probability) {
+    std::string query;
+    for (size_t i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (GenerateUniform() < minus_probability) {
+            query.push_back('-');
+        }
+        query += GetWord(GenerateWordRank());
+    }
+    return query;
+}
+
+std::vector<std::string> ZipfCorpusGenerator::GenerateQueries(size_t query_count, size_t max_word_count, double minus_probability) {
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (size_t i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(1 + GenerateIndex(max_word_count), minus_probability));
+    }
+    return queries;
+}
+
+uint64_t ZipfCorpusGenerator::GenerateIndex(uint64_t bound) {
+    return static_cast<uint64_t>(GenerateUniform() * bound);
+}
+
+double ZipfCorpusGenerator::GenerateUniform() {
+    // 53 старших бита дают равномерное число из [0, 1) с полной точностью double
+    return (generator_() >> 11) * (1.0 / (uint64_t{1} << 53));
+}
+
+double ZipfCorpusGenerator::GenerateStandardNormal() {
+    // преобразование Бокса - Мюллера
+    const double PI = 3.14159265358979323846;
+    const double u1 = 1.0 - GenerateUniform();
+    const double u2 = GenerateUniform();
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * PI * u2);
+}
+
+size_t ZipfCorpusGenerator::GenerateWordRank() {
+    const double u = GenerateUniform();
+    const auto it = std::upper_bound(cumulative_probabilities_.begin(), cumulative_probabilities_.end(), u);
+    return std::min<size_t>(it - cumulative_probabilities_.begin(), options_.vocabulary_size - 1);
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// параметры синтетической коллекции документов
+struct CorpusOptions {
+    uint64_t seed = 42;
+    // размер словаря и показатель степени распределения Ципфа: частота слова ранга r пропорциональна 1 / r^s
+    size_t vocabulary_size = 50'000;
+    double zipf_exponent = 1.0;
+    // длина документа в словах распределена логнормально с заданной медианой и ограничена сверху
+    double median_document_length = 40.0;
+    double document_length_sigma = 0.8;
+    size_t max_document_length = 1'000;
+    // число самых частых слов, объявляемых стоп-словами
+    size_t stop_word_count = 20;
+};
+
+// генератор воспроизводимой коллекции документов и запросов с ципфовским распределением слов.
+// Все распределения вычисляются из сырого выхода mt19937_64, а не через стандартные
+// *_distribution, поэтому при одинаковом seed результат совпадает на любой стандартной библиотеке
+class ZipfCorpusGenerator {
+public:
+    explicit ZipfCorpusGenerator(const CorpusOptions& options);
+
+    // слово ранга rank: чем частотнее слово, тем оно короче
+    static std::string GetWord(size_t rank);
+
+    std::string GetStopWords() const;
+
+    std::string GenerateDocument();
+
+    std::vector<std::string> GenerateDocuments(size_t document_count);
+
+    // запрос из word_count слов, каждое из которых с вероятностью minus_probability становится минус-словом
+    std::string GenerateQuery(size_t word_count, double minus_probability);
+
+    // запросы длиной от 1 до max_word_count слов
+    std::vector<std::string> GenerateQueries(size_t query_count, size_t max_word_count, double minus_probability);
+
+    uint64_t GenerateIndex(uint64_t bound);
+
+private:
+    double GenerateUniform();
+
+    double GenerateStandardNormal();
+
+    size_t GenerateWordRank();
+
+    CorpusOptions options_;
+    std::mt19937_64 generator_;
+    // накопленные вероятности рангов слов
+    std::vector<double> cumulative_probabilities_;
+};
\ No newline at end of file
@@ -1,48 +1,452 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <map>
-#include <mutex>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 using namespace std::string_literals;
 
-template <typename Key, typename Value>
+// числовое значение ячейки ConcurrentMap: все операции атомарны, += и -= выполняются как fetch_add
+// (для чисел с плавающей точкой - циклом compare_exchange)
+template <typename Value>
+class AtomicValue {
+public:
+    Value Load() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+    operator Value() const {
+        return Load();
+    }
+
+    AtomicValue& operator=(Value value) {
+        value_.store(value, std::memory_order_relaxed);
+        return *this;
+    }
+
+    // возвращает значение до прибавления
+    Value FetchAdd(Value delta) {
+        if constexpr (std::is_integral_v<Value>) {
+            return value_.fetch_add(delta, std::memory_order_relaxed);
+        } else {
+            Value expected = value_.load(std::memory_order_relaxed);
+            while (!value_.compare_exchange_weak(expected, expected + delta, std::memory_order_relaxed)) {
+            }
+            return expected;
+        }
+    }
+
+    AtomicValue& operator+=(Value delta) {
+        FetchAdd(delta);
+        return *this;
+    }
+
+    AtomicValue& operator-=(Value delta) {
+        FetchAdd(-delta);
+        return *this;
+    }
+
+private:
+    std::atomic<Value> value_{ Value{} };
+};
+
+// потокобезопасный хеш-словарь с открытой адресацией. Ключи делятся по хешу между сегментами,
+// сегмент - цепочка таблиц с линейным пробированием, каждая следующая вчетверо больше предыдущей
+// (короткая цепочка - меньше таблиц на пути поиска).
+// Ячейка занимается CAS-переходом состояния, ключ в ней больше не меняется и не переезжает,
+// поэтому поиск, вставка и FetchAdd обходятся без блокировок. Если таблица заполнена на 3/4,
+// первая пустая ячейка на пути ключа запечатывается, и поиск продолжается в следующей таблице.
+// Удалённая ячейка помечается и может быть занята снова только тем же ключом; когда удалённых ячеек
+// в сегменте больше четверти его ёмкости, сегмент перестраивается в одну таблицу с живыми ключами.
+// Операции отмечаются в счётчике пользователей сегмента, перестройка выполняется, только когда
+// сегмент свободен, и иначе откладывается до следующего удаления.
+// Числовые значения хранятся в AtomicValue; нечисловое значение защищено спин-блокировкой ячейки,
+// которую удерживает объект Access. Key должен иметь конструктор по умолчанию.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
 class ConcurrentMap {
 public:
-    static_assert(std::is_integral_v<Key>, "ConcurrentMap supports only integer keys"s);
+    static constexpr bool HAS_ATOMIC_VALUE = std::is_arithmetic_v<Value> && !std::is_same_v<Value, bool>;
+
+    using StoredValue = std::conditional_t<HAS_ATOMIC_VALUE, AtomicValue<Value>, Value>;
+
+private:
+    enum SlotState : uint8_t {
+        EMPTY,
+        WRITING,
+        FULL,
+        ERASED,
+        SEALED
+    };
+
+    struct Slot {
+        std::atomic<uint8_t> state{ EMPTY };
+        std::atomic<bool> locked{ false };
+        Key key{};
+        StoredValue value{};
+    };
+
+    static void LockSlot(Slot& slot) {
+        while (slot.locked.exchange(true, std::memory_order_acquire)) {
+            while (slot.locked.load(std::memory_order_relaxed)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    struct Segment;
+
+public:
+    // удерживает сегмент от перестройки, пока существует
+    class SegmentGuard {
+    public:
+        explicit SegmentGuard(const Segment& segment)
+            : segment_(&segment) {
+            // быстрый путь - одно атомарное прибавление; во время перестройки счётчик отрицателен
+            while (segment.user_count.fetch_add(1, std::memory_order_acquire) < 0) {
+                segment.user_count.fetch_sub(1, std::memory_order_relaxed);
+                while (segment.user_count.load(std::memory_order_relaxed) < 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        SegmentGuard(SegmentGuard&& other) noexcept
+            : segment_(std::exchange(other.segment_, nullptr)) {
+        }
+
+        SegmentGuard(const SegmentGuard&) = delete;
+        SegmentGuard& operator=(const SegmentGuard&) = delete;
+
+        ~SegmentGuard() {
+            if (segment_) {
+                segment_->user_count.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+    private:
+        const Segment* segment_;
+    };
+
+    // снимает блокировку ячейки при уничтожении; для числовых значений ячейка не блокируется
+    class SlotGuard {
+    public:
+        explicit SlotGuard(Slot* slot)
+            : slot_(slot) {
+            if (slot_) {
+                LockSlot(*slot_);
+            }
+        }
+
+        SlotGuard(const SlotGuard&) = delete;
+        SlotGuard& operator=(const SlotGuard&) = delete;
+
+        ~SlotGuard() {
+            if (slot_) {
+                slot_->locked.store(false, std::memory_order_release);
+            }
+        }
+
+    private:
+        Slot* slot_;
+    };
 
     struct Access {
-        std::lock_guard<std::mutex> guard;
-        Value& ref_to_value;
+        SegmentGuard segment_guard;
+        SlotGuard guard;
+        StoredValue& ref_to_value;
     };
 
-    explicit ConcurrentMap(size_t bucket_count)
-        : buckets_(bucket_count) {
+    // segment_count - число сегментов (обычно число потоков); expected_size - ожидаемое число ключей,
+    // по которому выбирается размер первых таблиц сегментов: без него ключи расходятся по цепочке таблиц,
+    // и поиск заметно медленнее
+    explicit ConcurrentMap(size_t segment_count, size_t expected_size = 0)
+        : segments_(std::max<size_t>(segment_count, 1))
+        , first_table_capacity_(MIN_TABLE_CAPACITY) {
+        while (first_table_capacity_ * segments_.size() < 2 * expected_size) {
+            first_table_capacity_ *= 2;
+        }
+        for (Segment& segment : segments_) {
+            segment.first_table = std::make_unique<Table>(first_table_capacity_);
+        }
     }
 
+    ConcurrentMap(const ConcurrentMap&) = delete;
+    ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+
+    // значение отсутствующего ключа создаётся конструктором по умолчанию
     Access operator[](const Key& key) {
-        auto& bucket = buckets_[static_cast<uint64_t>(key) % buckets_.size()];
-        return { std::lock_guard<std::mutex>(bucket.mutex), bucket.map[key] };
+        const size_t hash = MixHash(key);
+        Segment& segment = GetSegment(hash);
+        SegmentGuard segment_guard(segment);
+        Slot* slot = FindSlot(segment, hash, key, true);
+        return { std::move(segment_guard), SlotGuard(HAS_ATOMIC_VALUE ? nullptr : slot), slot->value };
     }
 
-    std::map<Key, Value> BuildOrdinaryMap() {
-        std::map<Key, Value> result;
-        for (auto& [mutex, map] : buckets_) {
-            std::lock_guard g(mutex);
-            result.insert(map.begin(), map.end());
-        }
-        return result;
+    // атомарно прибавляет delta к значению ключа и возвращает прежнее значение
+    Value FetchAdd(const Key& key, Value delta) {
+        static_assert(HAS_ATOMIC_VALUE, "FetchAdd requires a numeric value type");
+        const size_t hash = MixHash(key);
+        Segment& segment = GetSegment(hash);
+        SegmentGuard segment_guard(segment);
+        return FindSlot(segment, hash, key, true)->value.FetchAdd(delta);
     }
-    
+
     void Erase(const Key& key) {
-        auto& bucket = buckets_[key % buckets_.size()];
-        std::lock_guard<std::mutex> g(bucket.mutex);
-        bucket.map.erase(key);
+        const size_t hash = MixHash(key);
+        Segment& segment = GetSegment(hash);
+        bool compact = false;
+        {
+            SegmentGuard segment_guard(segment);
+            Slot* slot = FindSlot(segment, hash, key, false);
+            uint8_t state = FULL;
+            if (slot && slot->state.compare_exchange_strong(state, ERASED, std::memory_order_acq_rel)) {
+                const size_t live_count = segment.live_count.fetch_sub(1, std::memory_order_relaxed) - 1;
+                compact = HasManyErasedSlots(segment, live_count);
+            }
+        }
+        if (compact) {
+            TryCompact(segment);
+        }
+    }
+
+    // число ключей в словаре; при одновременных вставках и удалениях - приблизительное
+    size_t GetSize() const {
+        size_t size = 0;
+        for (const Segment& segment : segments_) {
+            size += segment.live_count.load(std::memory_order_relaxed);
+        }
+        return size;
+    }
+
+    // число ячеек во всех таблицах, включая пустые и удалённые
+    size_t GetCapacity() const {
+        size_t capacity = 0;
+        for (const Segment& segment : segments_) {
+            SegmentGuard segment_guard(segment);
+            for (Table* table = segment.first_table.get(); table; table = table->next.load(std::memory_order_acquire)) {
+                capacity += table->capacity;
+            }
+        }
+        return capacity;
+    }
+
+    // обход ключей и значений без копирования словаря; вставки и удаления, выполняемые во время обхода,
+    // могут как попасть в него, так и не попасть, но каждый ключ встречается не больше одного раза
+    template <typename Function>
+    void ForEach(Function function) const {
+        for (const Segment& segment : segments_) {
+            SegmentGuard segment_guard(segment);
+            for (Table* table = segment.first_table.get(); table; table = table->next.load(std::memory_order_acquire)) {
+                for (size_t index = 0; index < table->capacity; ++index) {
+                    Slot& slot = table->slots[index];
+                    if (slot.state.load(std::memory_order_acquire) != FULL) {
+                        continue;
+                    }
+                    if constexpr (HAS_ATOMIC_VALUE) {
+                        function(slot.key, slot.value.Load());
+                    } else {
+                        SlotGuard guard(&slot);
+                        function(slot.key, static_cast<const Value&>(slot.value));
+                    }
+                }
+            }
+        }
+    }
+
+    std::map<Key, Value> BuildOrdinaryMap() const {
+        std::map<Key, Value> result;
+        ForEach([&result](const Key& key, const Value& value) {
+            result.emplace(key, value);
+        });
+        return result;
     }
 
 private:
-    struct Bucket {
-        std::mutex mutex;
-        std::map<Key, Value> map;
+    static const size_t MIN_TABLE_CAPACITY = 16;
+    static const size_t TABLE_GROWTH_FACTOR = 4;
+
+    struct Table {
+        explicit Table(size_t table_capacity)
+            : slots(std::make_unique<Slot[]>(table_capacity))
+            , capacity(table_capacity) {
+        }
+
+        ~Table() {
+            delete next.load(std::memory_order_relaxed);
+        }
+
+        std::unique_ptr<Slot[]> slots;
+        size_t capacity;
+        // число занятых когда-либо ячеек, включая удалённые; по нему таблица запечатывается
+        std::atomic<size_t> size{ 0 };
+        std::atomic<Table*> next{ nullptr };
     };
-    std::vector<Bucket> buckets_;
+
+    // значение счётчика пользователей сегмента на время перестройки
+    static constexpr int COMPACTING = std::numeric_limits<int>::min() / 2;
+
+    // сегменты выровнены по строке кеша, чтобы счётчики соседних сегментов не мешали друг другу
+    struct alignas(64) Segment {
+        std::unique_ptr<Table> first_table;
+        // число живых ключей сегмента, в отличие от Table::size без удалённых
+        std::atomic<size_t> live_count{ 0 };
+        // число операций, работающих с таблицами сегмента; COMPACTING - сегмент перестраивается
+        mutable std::atomic<int> user_count{ 0 };
+    };
+
+    Segment& GetSegment(size_t hash) {
+        // сегмент выбирается по старшим битам хеша, ячейка - по младшим
+        return segments_[(hash >> 40) % segments_.size()];
+    }
+
+    // удалённых ячеек больше четверти ёмкости цепочки таблиц сегмента
+    static bool HasManyErasedSlots(const Segment& segment, size_t live_count) {
+        size_t filled = 0;
+        size_t capacity = 0;
+        for (Table* table = segment.first_table.get(); table; table = table->next.load(std::memory_order_acquire)) {
+            filled += table->size.load(std::memory_order_relaxed);
+            capacity += table->capacity;
+        }
+        return filled > live_count + capacity / 4;
+    }
+
+    // переносит живые ключи сегмента в одну новую таблицу, заполненную не больше чем наполовину;
+    // если с сегментом работает другая операция, перестройка пропускается
+    void TryCompact(Segment& segment) {
+        int users = 0;
+        if (!segment.user_count.compare_exchange_strong(users, COMPACTING, std::memory_order_acquire)) {
+            return;
+        }
+        try {
+            const size_t live_count = segment.live_count.load(std::memory_order_relaxed);
+            size_t capacity = first_table_capacity_;
+            while (capacity / 2 < live_count) {
+                capacity *= 2;
+            }
+            auto compacted = std::make_unique<Table>(capacity);
+            const size_t mask = capacity - 1;
+            for (Table* table = segment.first_table.get(); table; table = table->next.load(std::memory_order_relaxed)) {
+                for (size_t index = 0; index < table->capacity; ++index) {
+                    Slot& slot = table->slots[index];
+                    if (slot.state.load(std::memory_order_relaxed) != FULL) {
+                        continue;
+                    }
+                    // ключи уникальны, поэтому достаточно найти первую пустую ячейку
+                    size_t target_index = MixHash(slot.key) & mask;
+                    while (compacted->slots[target_index].state.load(std::memory_order_relaxed) != EMPTY) {
+                        target_index = (target_index + 1) & mask;
+                    }
+                    Slot& target = compacted->slots[target_index];
+                    target.key = std::move(slot.key);
+                    if constexpr (HAS_ATOMIC_VALUE) {
+                        target.value = slot.value.Load();
+                    } else {
+                        target.value = std::move(slot.value);
+                    }
+                    target.state.store(FULL, std::memory_order_relaxed);
+                }
+            }
+            compacted->size.store(live_count, std::memory_order_relaxed);
+            segment.first_table = std::move(compacted);
+        } catch (...) {
+            segment.user_count.fetch_sub(COMPACTING, std::memory_order_release);
+            throw;
+        }
+        // ожидающие операции могли прибавить к счётчику по единице, поэтому он не обнуляется, а возвращается
+        segment.user_count.fetch_sub(COMPACTING, std::memory_order_release);
+    }
+
+    // std::hash целых чисел тождественен, поэтому хеш перемешивается финализатором MurmurHash3
+    size_t MixHash(const Key& key) const {
+        uint64_t hash = hasher_(key);
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    // ячейка ключа в удерживаемом сегменте; при insert отсутствующий ключ добавляется, иначе возвращается nullptr
+    Slot* FindSlot(Segment& segment, size_t hash, const Key& key, bool insert) {
+        Table* table = segment.first_table.get();
+        while (true) {
+            const size_t mask = table->capacity - 1;
+            size_t index = hash & mask;
+            for (size_t probe = 0; probe < table->capacity; ++probe, index = (index + 1) & mask) {
+                Slot& slot = table->slots[index];
+                uint8_t state = slot.state.load(std::memory_order_acquire);
+                if (state == EMPTY) {
+                    if (!insert) {
+                        return nullptr;
+                    }
+                    const uint8_t target = table->size.load(std::memory_order_relaxed) < table->capacity / 4 * 3 ? WRITING : SEALED;
+                    if (slot.state.compare_exchange_strong(state, target, std::memory_order_acq_rel)) {
+                        if (target == SEALED) {
+                            break;
+                        }
+                        table->size.fetch_add(1, std::memory_order_relaxed);
+                        segment.live_count.fetch_add(1, std::memory_order_relaxed);
+                        slot.key = key;
+                        slot.state.store(FULL, std::memory_order_release);
+                        return &slot;
+                    }
+                    // ячейку успел занять или запечатать другой поток: state уже содержит её новое состояние
+                }
+                while (state == WRITING) {
+                    std::this_thread::yield();
+                    state = slot.state.load(std::memory_order_acquire);
+                }
+                if (state == SEALED) {
+                    break;
+                }
+                if (!equal_(slot.key, key)) {
+                    continue;
+                }
+                if (!insert || state == FULL) {
+                    return state == FULL ? &slot : nullptr;
+                }
+                // удалённый ключ: при вставке ячейка оживает с новым значением, если её не оживил другой поток
+                while (state != FULL) {
+                    if (state == ERASED && slot.state.compare_exchange_strong(state, WRITING, std::memory_order_acq_rel)) {
+                        {
+                            SlotGuard guard(HAS_ATOMIC_VALUE ? nullptr : &slot);
+                            slot.value = Value{};
+                        }
+                        segment.live_count.fetch_add(1, std::memory_order_relaxed);
+                        slot.state.store(FULL, std::memory_order_release);
+                        return &slot;
+                    }
+                    while (state == WRITING) {
+                        std::this_thread::yield();
+                        state = slot.state.load(std::memory_order_acquire);
+                    }
+                }
+                return &slot;
+            }
+            Table* next = table->next.load(std::memory_order_acquire);
+            if (!next) {
+                if (!insert) {
+                    return nullptr;
+                }
+                auto created = std::make_unique<Table>(table->capacity * TABLE_GROWTH_FACTOR);
+                if (table->next.compare_exchange_strong(next, created.get(), std::memory_order_acq_rel)) {
+                    next = created.release();
+                }
+            }
+            table = next;
+        }
+    }
+
+    std::vector<Segment> segments_;
+    // ёмкость первой таблицы сегмента, от неё же растёт перестроенная таблица
+    size_t first_table_capacity_;
+    Hash hasher_;
+    KeyEqual equal_;
 };
\ No newline at end of file
@@ -0,0 +1,16 @@
+#include "document_filter.h"
+
+DocumentFilter DocumentFilter::ByStatus(DocumentStatus status) {
+    DocumentFilter filter;
+    filter.status = status;
+    return filter;
+}
+
+bool DocumentFilter::operator()(int document_id, DocumentStatus document_status, int rating) const {
+    return (!status || document_status == *status)
+        && (!min_rating || rating >= *min_rating)
+        && (!max_rating || rating <= *max_rating)
+        && (!min_id || document_id >= *min_id)
+        && (!max_id || document_id <= *max_id)
+        && (id_parity == IdParity::ANY || (document_id % 2 == 0) == (id_parity == IdParity::EVEN));
+}
\ No newline at end of file
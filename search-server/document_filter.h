@@ -0,0 +1,31 @@
+#pragma once
+#include <optional>
+
+#include "document.h"
+
+// декларативный фильтр документов: в отличие от произвольного предиката его условия известны серверу,
+// поэтому фильтр по статусу пересекается с битовой картой документов этого статуса,
+// а диапазон id ограничивает обход списка документов слова
+struct DocumentFilter {
+    enum class IdParity {
+        ANY,
+        EVEN,
+        ODD
+    };
+
+    // у всех условий есть значения по умолчанию, поэтому при агрегатной инициализации
+    // можно указать только первые из них
+    std::optional<DocumentStatus> status = std::nullopt;
+    std::optional<int> min_rating = std::nullopt;
+    std::optional<int> max_rating = std::nullopt;
+    // границы диапазона id включаются в диапазон
+    std::optional<int> min_id = std::nullopt;
+    std::optional<int> max_id = std::nullopt;
+    IdParity id_parity = IdParity::ANY;
+
+    // фильтр только по статусу документа
+    static DocumentFilter ByStatus(DocumentStatus status);
+
+    // фильтр можно использовать и как обычный предикат
+    bool operator()(int document_id, DocumentStatus document_status, int rating) const;
+};
\ No newline at end of file
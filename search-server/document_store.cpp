@@ -0,0 +1,595 @@
+#include "document_store.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <cstring>
+#include <stdexcept>
+
+#include "metrics.h"
+
+// LZ77 ищет совпадения по хешу первых четырёх байт и принимает совпадения не короче MIN_MATCH_LENGTH:
+// более короткие обходятся дороже литералов, закодированных кодом Хаффмана
+static const size_t HASHED_LENGTH = 4;
+static const size_t MIN_MATCH_LENGTH = 6;
+static const size_t MAX_MATCH_OFFSET = 65535;
+static const int HASH_BITS = 14;
+static const uint32_t NO_POSITION = UINT32_MAX;
+
+// наибольшая длина кода Хаффмана: таблица декодирования занимает 2^12 записей
+static const int MAX_CODE_LENGTH = 12;
+static const size_t SYMBOL_COUNT = 256;
+static const size_t HUFFMAN_HEADER_SIZE = 4 + SYMBOL_COUNT / 2;
+// способ записи потока: байты как есть или код Хаффмана
+static const uint8_t STREAM_RAW = 0;
+static const uint8_t STREAM_HUFFMAN = 1;
+
+// выход LZ77 разделён на литералы и последовательности (токены, продолжения длин и смещения):
+// статистика байтов у них разная, и каждый поток кодируется своим кодом Хаффмана
+struct LzStreams {
+    std::vector<uint8_t> literals;
+    std::vector<uint8_t> sequences;
+};
+
+static void ThrowCorruptedBlock() {
+    throw std::runtime_error("Corrupted document store block"s);
+}
+
+static void WriteUint32(std::vector<uint8_t>& out, size_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+static size_t ReadUint32(const uint8_t* data, size_t size, size_t& pos) {
+    if (pos + 4 > size) {
+        ThrowCorruptedBlock();
+    }
+    size_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<size_t>(data[pos++]) << (8 * i);
+    }
+    return value;
+}
+
+static uint32_t HashSequence(const char* data) {
+    uint32_t sequence;
+    std::memcpy(&sequence, data, sizeof(sequence));
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// длина в полубайте токена; значения от 15 продолжаются байтами 255 и остатком
+static void WriteLengthExtension(std::vector<uint8_t>& out, size_t length) {
+    if (length < 15) {
+        return;
+    }
+    length -= 15;
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+static size_t ReadLengthExtension(const uint8_t* data, size_t size, size_t& pos, size_t length) {
+    if (length < 15) {
+        return length;
+    }
+    uint8_t byte;
+    do {
+        if (pos >= size) {
+            ThrowCorruptedBlock();
+        }
+        byte = data[pos++];
+        length += byte;
+    } while (byte == 255);
+    return length;
+}
+
+// последовательность: токен с длинами литералов и совпадения, продолжение длины литералов, смещение
+// и продолжение длины совпадения; у последней последовательности совпадения нет
+static void WriteSequence(LzStreams& streams, std::string_view literals, size_t offset, size_t match_length) {
+    const size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH_LENGTH;
+    auto& out = streams.sequences;
+    out.push_back(static_cast<uint8_t>((std::min<size_t>(literals.size(), 15) << 4) | std::min<size_t>(match_code, 15)));
+    WriteLengthExtension(out, literals.size());
+    streams.literals.insert(streams.literals.end(), literals.begin(), literals.end());
+    if (match_length == 0) {
+        return;
+    }
+    out.push_back(static_cast<uint8_t>(offset & 0xFF));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    WriteLengthExtension(out, match_code);
+}
+
+static LzStreams CompressLz(std::string_view data) {
+    LzStreams streams;
+    streams.literals.reserve(data.size());
+    std::vector<uint32_t> last_positions(size_t{1} << HASH_BITS, NO_POSITION);
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + HASHED_LENGTH <= data.size()) {
+        const uint32_t hash = HashSequence(data.data() + pos);
+        const uint32_t candidate = last_positions[hash];
+        last_positions[hash] = static_cast<uint32_t>(pos);
+        if (candidate == NO_POSITION || pos - candidate > MAX_MATCH_OFFSET) {
+            ++pos;
+            continue;
+        }
+        size_t match_length = 0;
+        while (pos + match_length < data.size() && data[candidate + match_length] == data[pos + match_length]) {
+            ++match_length;
+        }
+        if (match_length < MIN_MATCH_LENGTH) {
+            ++pos;
+            continue;
+        }
+        WriteSequence(streams, data.substr(anchor, pos - anchor), pos - candidate, match_length);
+        // позиции внутри совпадения тоже попадают в таблицу: это заметно улучшает сжатие повторяющихся фраз
+        for (size_t inner = pos + 1; inner < pos + match_length && inner + HASHED_LENGTH <= data.size(); ++inner) {
+            last_positions[HashSequence(data.data() + inner)] = static_cast<uint32_t>(inner);
+        }
+        pos += match_length;
+        anchor = pos;
+    }
+    WriteSequence(streams, data.substr(anchor), 0, 0);
+    return streams;
+}
+
+static std::string DecompressLz(const LzStreams& streams, size_t raw_size) {
+    std::string out(raw_size, '\0');
+    const uint8_t* sequences = streams.sequences.data();
+    const size_t sequences_size = streams.sequences.size();
+    size_t out_pos = 0;
+    size_t literal_pos = 0;
+    size_t pos = 0;
+    while (out_pos < raw_size) {
+        if (pos >= sequences_size) {
+            ThrowCorruptedBlock();
+        }
+        const uint8_t token = sequences[pos++];
+        const size_t literal_length = ReadLengthExtension(sequences, sequences_size, pos, token >> 4);
+        if (literal_pos + literal_length > streams.literals.size() || out_pos + literal_length > raw_size) {
+            ThrowCorruptedBlock();
+        }
+        std::memcpy(out.data() + out_pos, streams.literals.data() + literal_pos, literal_length);
+        literal_pos += literal_length;
+        out_pos += literal_length;
+        if (out_pos == raw_size) {
+            break;
+        }
+        if (pos + 2 > sequences_size) {
+            ThrowCorruptedBlock();
+        }
+        const size_t offset = sequences[pos] | (static_cast<size_t>(sequences[pos + 1]) << 8);
+        pos += 2;
+        const size_t match_length = ReadLengthExtension(sequences, sequences_size, pos, token & 15) + MIN_MATCH_LENGTH;
+        if (offset == 0 || offset > out_pos || out_pos + match_length > raw_size) {
+            ThrowCorruptedBlock();
+        }
+        // совпадение может перекрываться с самим собой, поэтому копирование побайтовое
+        for (size_t i = 0; i < match_length; ++i, ++out_pos) {
+            out[out_pos] = out[out_pos - offset];
+        }
+    }
+    return out;
+}
+
+// длины кодов Хаффмана по частотам байтов; если код оказался длиннее MAX_CODE_LENGTH,
+// частоты сглаживаются делением пополам и код строится заново
+static std::array<uint8_t, SYMBOL_COUNT> BuildCodeLengths(std::array<uint64_t, SYMBOL_COUNT> frequencies) {
+    std::array<uint8_t, SYMBOL_COUNT> lengths = {};
+    while (true) {
+        // листья - символы 0..255, внутренние узлы нумеруются следом
+        std::vector<std::pair<uint64_t, int>> heap;
+        for (size_t symbol = 0; symbol < SYMBOL_COUNT; ++symbol) {
+            if (frequencies[symbol] > 0) {
+                heap.emplace_back(frequencies[symbol], static_cast<int>(symbol));
+            }
+        }
+        if (heap.size() <= 1) {
+            for (const auto& [frequency, symbol] : heap) {
+                lengths[symbol] = 1;
+            }
+            return lengths;
+        }
+        std::vector<int> parents(2 * SYMBOL_COUNT, -1);
+        int next_node = SYMBOL_COUNT;
+        std::make_heap(heap.begin(), heap.end(), std::greater<>{});
+        while (heap.size() > 1) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+            const auto first = heap.back();
+            heap.pop_back();
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+            const auto second = heap.back();
+            heap.pop_back();
+            parents[first.second] = parents[second.second] = next_node;
+            heap.emplace_back(first.first + second.first, next_node++);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+        }
+        int max_length = 0;
+        for (size_t symbol = 0; symbol < SYMBOL_COUNT; ++symbol) {
+            int length = 0;
+            if (frequencies[symbol] > 0) {
+                for (int node = symbol; parents[node] != -1; node = parents[node]) {
+                    ++length;
+                }
+            }
+            lengths[symbol] = static_cast<uint8_t>(length);
+            max_length = std::max(max_length, length);
+        }
+        if (max_length <= MAX_CODE_LENGTH) {
+            return lengths;
+        }
+        for (uint64_t& frequency : frequencies) {
+            frequency = frequency == 0 ? 0 : (frequency + 1) / 2;
+        }
+    }
+}
+
+// канонический код: символы упорядочены по длине кода, а при равной длине - по значению
+static std::array<uint16_t, SYMBOL_COUNT> BuildCanonicalCodes(const std::array<uint8_t, SYMBOL_COUNT>& lengths) {
+    std::array<uint16_t, SYMBOL_COUNT> codes = {};
+    uint16_t code = 0;
+    for (int length = 1; length <= MAX_CODE_LENGTH; ++length) {
+        for (size_t symbol = 0; symbol < SYMBOL_COUNT; ++symbol) {
+            if (lengths[symbol] == length) {
+                codes[symbol] = code++;
+            }
+        }
+        code <<= 1;
+    }
+    return codes;
+}
+
+// поток кода Хаффмана: длины кодов по полубайту на символ, затем коды старшими битами вперёд
+static std::vector<uint8_t> EncodeHuffman(const std::vector<uint8_t>& data) {
+    std::array<uint64_t, SYMBOL_COUNT> frequencies = {};
+    for (uint8_t byte : data) {
+        ++frequencies[byte];
+    }
+    const auto lengths = BuildCodeLengths(frequencies);
+    const auto codes = BuildCanonicalCodes(lengths);
+    std::vector<uint8_t> out;
+    out.reserve(data.size() + HUFFMAN_HEADER_SIZE);
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol += 2) {
+        out.push_back(static_cast<uint8_t>(lengths[symbol] | (lengths[symbol + 1] << 4)));
+    }
+    uint64_t bits = 0;
+    int bit_count = 0;
+    for (uint8_t byte : data) {
+        bits = (bits << lengths[byte]) | codes[byte];
+        bit_count += lengths[byte];
+        while (bit_count >= 8) {
+            bit_count -= 8;
+            out.push_back(static_cast<uint8_t>(bits >> bit_count));
+        }
+    }
+    if (bit_count > 0) {
+        out.push_back(static_cast<uint8_t>(bits << (8 - bit_count)));
+    }
+    return out;
+}
+
+static void DecodeHuffman(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    if (size < SYMBOL_COUNT / 2) {
+        ThrowCorruptedBlock();
+    }
+    std::array<uint8_t, SYMBOL_COUNT> lengths;
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol += 2) {
+        lengths[symbol] = data[symbol / 2] & 15;
+        lengths[symbol + 1] = data[symbol / 2] >> 4;
+    }
+    const auto codes = BuildCanonicalCodes(lengths);
+    // запись таблицы по первым MAX_CODE_LENGTH битам потока: символ и длина его кода
+    std::vector<uint16_t> table(size_t{1} << MAX_CODE_LENGTH);
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; ++symbol) {
+        const int length = lengths[symbol];
+        if (length == 0) {
+            continue;
+        }
+        const size_t first = static_cast<size_t>(codes[symbol]) << (MAX_CODE_LENGTH - length);
+        std::fill(table.begin() + first, table.begin() + first + (size_t{1} << (MAX_CODE_LENGTH - length)),
+                  static_cast<uint16_t>(symbol | (length << 8)));
+    }
+
+    size_t pos = SYMBOL_COUNT / 2;
+    uint64_t bits = 0;
+    int bit_count = 0;
+    for (uint8_t& byte : out) {
+        // за концом потока читаются нули: последний код может быть короче MAX_CODE_LENGTH
+        while (bit_count < MAX_CODE_LENGTH) {
+            bits = (bits << 8) | (pos < size ? data[pos] : 0);
+            ++pos;
+            bit_count += 8;
+        }
+        const uint16_t entry = table[(bits >> (bit_count - MAX_CODE_LENGTH)) & ((1u << MAX_CODE_LENGTH) - 1)];
+        if ((entry >> 8) == 0) {
+            ThrowCorruptedBlock();
+        }
+        byte = static_cast<uint8_t>(entry);
+        bit_count -= entry >> 8;
+    }
+}
+
+// поток: способ записи, исходная длина и длина записи; код Хаффмана не помогает
+// на несжимаемых и коротких данных, тогда поток хранится как есть
+static void WriteStream(std::vector<uint8_t>& out, const std::vector<uint8_t>& data) {
+    const std::vector<uint8_t> huffman = EncodeHuffman(data);
+    const bool use_huffman = huffman.size() < data.size();
+    const auto& payload = use_huffman ? huffman : data;
+    out.push_back(use_huffman ? STREAM_HUFFMAN : STREAM_RAW);
+    WriteUint32(out, data.size());
+    WriteUint32(out, payload.size());
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+static std::vector<uint8_t> ReadStream(const std::vector<uint8_t>& data, size_t& pos) {
+    if (pos >= data.size()) {
+        ThrowCorruptedBlock();
+    }
+    const uint8_t method = data[pos++];
+    std::vector<uint8_t> out(ReadUint32(data.data(), data.size(), pos));
+    const size_t payload_size = ReadUint32(data.data(), data.size(), pos);
+    if (pos + payload_size > data.size()) {
+        ThrowCorruptedBlock();
+    }
+    if (method == STREAM_HUFFMAN) {
+        DecodeHuffman(data.data() + pos, payload_size, out);
+    } else if (method == STREAM_RAW && payload_size == out.size()) {
+        std::copy(data.begin() + pos, data.begin() + pos + payload_size, out.begin());
+    } else {
+        ThrowCorruptedBlock();
+    }
+    pos += payload_size;
+    return out;
+}
+
+std::vector<uint8_t> CompressBlock(std::string_view data) {
+    const LzStreams streams = CompressLz(data);
+    std::vector<uint8_t> out;
+    WriteStream(out, streams.literals);
+    WriteStream(out, streams.sequences);
+    out.shrink_to_fit();
+    return out;
+}
+
+std::string DecompressBlock(const std::vector<uint8_t>& data, size_t raw_size) {
+    size_t pos = 0;
+    LzStreams streams;
+    streams.literals = ReadStream(data, pos);
+    streams.sequences = ReadStream(data, pos);
+    return DecompressLz(streams, raw_size);
+}
+
+DocumentStore::DocumentStore(size_t block_size, size_t cache_block_count)
+    : block_size_(block_size)
+    , cache_block_count_(std::max<size_t>(cache_block_count, 1))
+    , cache_(std::make_unique<BlockCache>()) {
+}
+
+DocumentStore::DocumentStore(const DocumentStore& other)
+    : block_size_(other.block_size_)
+    , cache_block_count_(other.cache_block_count_)
+    , document_locations_(other.document_locations_)
+    , blocks_(other.blocks_)
+    , open_block_(other.open_block_)
+    , open_block_live_bytes_(other.open_block_live_bytes_)
+    , text_bytes_(other.text_bytes_)
+    , cache_(std::make_unique<BlockCache>()) {
+}
+
+DocumentStore& DocumentStore::operator=(const DocumentStore& other) {
+    if (this != &other) {
+        DocumentStore copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+void DocumentStore::Add(int document_id, std::string_view text) {
+    if (document_id < 0) {
+        throw std::invalid_argument("Trying to add a document with a negative id"s);
+    } else if (Contains(document_id)) {
+        throw std::invalid_argument("id "s + std::to_string(document_id) + " already exists in the document store"s);
+    }
+    const Location location{ static_cast<uint32_t>(blocks_.size()), static_cast<uint32_t>(open_block_.size()),
+                             static_cast<uint32_t>(text.size()) };
+    // при исключении во время дописывания текста расположение документа удаляется
+    const auto location_it = document_locations_.emplace(document_id, location).first;
+    try {
+        open_block_.append(text);
+    } catch (...) {
+        document_locations_.erase(location_it);
+        throw;
+    }
+    open_block_live_bytes_ += text.size();
+    text_bytes_ += text.size();
+    if (open_block_.size() >= block_size_) {
+        SealOpenBlock();
+    }
+}
+
+void DocumentStore::SealOpenBlock() {
+    Block block;
+    block.data = CompressBlock(open_block_);
+    block.raw_size = static_cast<uint32_t>(open_block_.size());
+    block.live_bytes = open_block_live_bytes_;
+    blocks_.push_back(std::move(block));
+    open_block_.clear();
+    open_block_live_bytes_ = 0;
+}
+
+void DocumentStore::Remove(int document_id) {
+    const auto location_it = document_locations_.find(document_id);
+    if (location_it == document_locations_.end()) {
+        return;
+    }
+    const Location location = location_it->second;
+    document_locations_.erase(location_it);
+    text_bytes_ -= location.length;
+    if (location.block == blocks_.size()) {
+        open_block_live_bytes_ -= location.length;
+        return;
+    }
+    Block& block = blocks_[location.block];
+    block.live_bytes -= location.length;
+    if (block.live_bytes == 0) {
+        block.data = {};
+        EvictBlock(location.block);
+    }
+}
+
+bool DocumentStore::Contains(int document_id) const {
+    return document_locations_.count(document_id) > 0;
+}
+
+std::string DocumentStore::GetText(int document_id) const {
+    const auto location_it = document_locations_.find(document_id);
+    if (location_it == document_locations_.end()) {
+        throw std::out_of_range("Requested id "s + std::to_string(document_id) + " is not in the document store"s);
+    }
+    const Location& location = location_it->second;
+    if (location.block == blocks_.size()) {
+        return open_block_.substr(location.offset, location.length);
+    }
+    return GetBlock(location.block)->substr(location.offset, location.length);
+}
+
+std::shared_ptr<const std::string> DocumentStore::GetBlock(uint32_t block) const {
+    {
+        std::lock_guard guard(cache_->mutex);
+        const auto it = cache_->block_to_position.find(block);
+        if (it != cache_->block_to_position.end()) {
+            cache_->blocks.splice(cache_->blocks.begin(), cache_->blocks, it->second);
+            METRICS_COUNT(MetricsCounter::DOCUMENT_STORE_CACHE_HITS, 1);
+            return it->second->second;
+        }
+    }
+    METRICS_COUNT(MetricsCounter::DOCUMENT_STORE_CACHE_MISSES, 1);
+    // распаковка выполняется без блокировки; если блок успел распаковать другой поток, берётся его копия
+    auto text = std::make_shared<const std::string>(DecompressBlock(blocks_[block].data, blocks_[block].raw_size));
+    std::lock_guard guard(cache_->mutex);
+    const auto it = cache_->block_to_position.find(block);
+    if (it != cache_->block_to_position.end()) {
+        return it->second->second;
+    }
+    cache_->blocks.emplace_front(block, text);
+    cache_->block_to_position[block] = cache_->blocks.begin();
+    if (cache_->blocks.size() > cache_block_count_) {
+        cache_->block_to_position.erase(cache_->blocks.back().first);
+        cache_->blocks.pop_back();
+    }
+    return text;
+}
+
+void DocumentStore::EvictBlock(uint32_t block) {
+    std::lock_guard guard(cache_->mutex);
+    const auto it = cache_->block_to_position.find(block);
+    if (it != cache_->block_to_position.end()) {
+        cache_->blocks.erase(it->second);
+        cache_->block_to_position.erase(it);
+    }
+}
+
+std::vector<std::string> DocumentStore::GetSnippets(int document_id, const std::vector<std::string_view>& words,
+                                                    const SnippetOptions& options) const {
+    const std::string text = GetText(document_id);
+    std::vector<std::string_view> text_words;
+    for (size_t pos = text.find_first_not_of(' '); pos != text.npos; pos = text.find_first_not_of(' ', pos)) {
+        const size_t end = std::min(text.find(' ', pos), text.size());
+        text_words.push_back(std::string_view(text).substr(pos, end - pos));
+        pos = end;
+    }
+    if (text_words.empty() || options.max_fragment_count == 0) {
+        return {};
+    }
+
+    std::vector<std::string_view> sorted_words(words.begin(), words.end());
+    std::sort(sorted_words.begin(), sorted_words.end());
+    const size_t word_count = text_words.size();
+    const size_t window = std::clamp<size_t>(options.fragment_word_count, 1, word_count);
+    std::vector<bool> is_hit(word_count);
+    for (size_t i = 0; i < word_count; ++i) {
+        is_hit[i] = std::binary_search(sorted_words.begin(), sorted_words.end(), text_words[i]);
+    }
+
+    // жадный выбор окон: окно не пересекает уже выбранные и содержит больше всего вхождений;
+    // найденные вхождения затем по возможности сдвигаются к середине окна
+    std::vector<bool> is_covered(word_count);
+    std::vector<size_t> fragment_begins;
+    std::vector<size_t> hit_prefix(word_count + 1);
+    std::vector<size_t> covered_prefix(word_count + 1);
+    while (fragment_begins.size() < options.max_fragment_count) {
+        for (size_t i = 0; i < word_count; ++i) {
+            hit_prefix[i + 1] = hit_prefix[i] + is_hit[i];
+            covered_prefix[i + 1] = covered_prefix[i] + is_covered[i];
+        }
+        const auto is_free = [&](size_t begin) { return covered_prefix[begin + window] == covered_prefix[begin]; };
+        size_t best_begin = 0;
+        size_t best_hits = 0;
+        for (size_t begin = 0; begin + window <= word_count; ++begin) {
+            const size_t hits = hit_prefix[begin + window] - hit_prefix[begin];
+            if (hits > best_hits && is_free(begin)) {
+                best_begin = begin;
+                best_hits = hits;
+            }
+        }
+        if (best_hits == 0) {
+            break;
+        }
+        size_t first_hit = best_begin;
+        while (!is_hit[first_hit]) {
+            ++first_hit;
+        }
+        size_t last_hit = best_begin + window - 1;
+        while (!is_hit[last_hit]) {
+            --last_hit;
+        }
+        const size_t slack = window - (last_hit - first_hit + 1);
+        const size_t centered_begin = std::min(first_hit - std::min(first_hit, slack / 2), word_count - window);
+        if (is_free(centered_begin)) {
+            best_begin = centered_begin;
+        }
+        std::fill(is_covered.begin() + best_begin, is_covered.begin() + best_begin + window, true);
+        fragment_begins.push_back(best_begin);
+    }
+    if (fragment_begins.empty()) {
+        fragment_begins.push_back(0);
+    }
+    std::sort(fragment_begins.begin(), fragment_begins.end());
+
+    std::vector<std::string> fragments;
+    fragments.reserve(fragment_begins.size());
+    for (size_t begin : fragment_begins) {
+        std::string fragment;
+        for (size_t i = begin; i < begin + window; ++i) {
+            if (i > begin) {
+                fragment += ' ';
+            }
+            if (is_hit[i]) {
+                fragment += options.highlight_begin;
+                fragment += text_words[i];
+                fragment += options.highlight_end;
+            } else {
+                fragment += text_words[i];
+            }
+        }
+        fragments.push_back(std::move(fragment));
+    }
+    return fragments;
+}
+
+size_t DocumentStore::GetTextBytes() const {
+    return text_bytes_;
+}
+
+size_t DocumentStore::GetMemoryBytes() const {
+    // узел дерева расположений - три указателя и цвет сверх хранимой пары
+    size_t bytes = blocks_.capacity() * sizeof(Block) + open_block_.capacity()
+        + document_locations_.size() * (sizeof(std::pair<const int, Location>) + 4 * sizeof(void*));
+    for (const Block& block : blocks_) {
+        bytes += block.data.capacity();
+    }
+    return bytes;
+}
\ No newline at end of file
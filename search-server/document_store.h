@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::string_literals;
+
+// параметры фрагментов текста документа для выдачи
+struct SnippetOptions {
+    // число слов во фрагменте и наибольшее число фрагментов
+    size_t fragment_word_count = 12;
+    size_t max_fragment_count = 2;
+    // обрамление найденных слов
+    std::string highlight_begin = "<b>"s;
+    std::string highlight_end = "</b>"s;
+};
+
+// хранилище исходных текстов документов: тексты дописываются в открытый блок, заполненный блок
+// сжимается LZ77-кодеком в формате, близком к LZ4 (токен с длинами литералов и совпадения, 16-битное смещение),
+// литералы и последовательности которого кодируются раздельными каноническими кодами Хаффмана;
+// распакованные блоки кешируются в LRU-кеше, поэтому фрагменты соседних по добавлению документов
+// не требуют повторной распаковки. Константные методы можно вызывать из нескольких потоков
+class DocumentStore {
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 16 * 1024;
+    static const size_t DEFAULT_CACHE_BLOCK_COUNT = 16;
+
+    explicit DocumentStore(size_t block_size = DEFAULT_BLOCK_SIZE, size_t cache_block_count = DEFAULT_CACHE_BLOCK_COUNT);
+
+    // копия получает собственный пустой кеш
+    DocumentStore(const DocumentStore& other);
+    DocumentStore& operator=(const DocumentStore& other);
+    DocumentStore(DocumentStore&&) = default;
+    DocumentStore& operator=(DocumentStore&&) = default;
+
+    void Add(int document_id, std::string_view text);
+
+    // память блока освобождается, когда из него удалены все документы
+    void Remove(int document_id);
+
+    bool Contains(int document_id) const;
+
+    std::string GetText(int document_id) const;
+
+    // до max_fragment_count непересекающихся фрагментов по fragment_word_count слов в порядке следования в тексте;
+    // фрагменты выбираются жадно по числу ещё не показанных вхождений слов words, которые обрамляются
+    // highlight_begin и highlight_end; если слова в тексте не встречаются, возвращается начало текста
+    std::vector<std::string> GetSnippets(int document_id, const std::vector<std::string_view>& words,
+                                         const SnippetOptions& options = {}) const;
+
+    // суммарная длина хранимых текстов и занимаемая хранилищем память (без кеша), в байтах
+    size_t GetTextBytes() const;
+
+    size_t GetMemoryBytes() const;
+
+private:
+    struct Location {
+        uint32_t block = 0;
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    struct Block {
+        std::vector<uint8_t> data;
+        uint32_t raw_size = 0;
+        uint32_t live_bytes = 0;
+    };
+
+    // кеш распакованных блоков: список упорядочен от недавно использованных к давно использованным
+    struct BlockCache {
+        std::mutex mutex;
+        std::list<std::pair<uint32_t, std::shared_ptr<const std::string>>> blocks;
+        std::unordered_map<uint32_t, decltype(blocks)::iterator> block_to_position;
+    };
+
+    void SealOpenBlock();
+
+    std::shared_ptr<const std::string> GetBlock(uint32_t block) const;
+
+    void EvictBlock(uint32_t block);
+
+    size_t block_size_;
+    size_t cache_block_count_;
+    // расположение текста по id документа; словарь, а не массив с индексом по id, чтобы память
+    // не зависела от величины id
+    std::map<int, Location> document_locations_;
+    std::vector<Block> blocks_;
+    // незаполненный блок хранится несжатым, его номер - blocks_.size()
+    std::string open_block_;
+    uint32_t open_block_live_bytes_ = 0;
+    size_t text_bytes_ = 0;
+    std::unique_ptr<BlockCache> cache_;
+};
+
+// сжатие и распаковка блока; для распаковки нужен исходный размер
+std::vector<uint8_t> CompressBlock(std::string_view data);
+
+std::string DecompressBlock(const std::vector<uint8_t>& data, size_t raw_size);
\ No newline at end of file
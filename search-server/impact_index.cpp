@@ -0,0 +1,183 @@
+#include "impact_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std::string_literals;
+
+// шаг квантования выбирается так, чтобы наибольший вклад занял весь 16-битный диапазон;
+// вклад записи округляется до ближайшего кратного шага, но не меньше одного шага,
+// чтобы документ с нулевым IDF слова всё равно попадал в выдачу, как и при точном ранжировании
+ImpactIndex::ImpactIndex(const SearchServer& search_server) {
+    const auto scorer = search_server.PrepareScoring(TfIdfScoring());
+    double max_impact = 0.0;
+    for (const auto& [word, document_freqs] : search_server.word_to_document_freqs_) {
+        if (document_freqs.empty()) {
+            continue;
+        }
+        const double IDF = scorer.ComputeIdf(document_freqs.size());
+        for (const auto [document_id, TF] : document_freqs) {
+            max_impact = std::max(max_impact, scorer.Score(TF, IDF, 0));
+        }
+    }
+    constexpr double MAX_QUANTIZED_IMPACT = std::numeric_limits<uint16_t>::max();
+    quantization_step_ = max_impact / MAX_QUANTIZED_IMPACT;
+
+    std::vector<std::pair<uint16_t, uint32_t>> postings;
+    for (const auto& [word, document_freqs] : search_server.word_to_document_freqs_) {
+        if (document_freqs.empty()) {
+            continue;
+        }
+        const double IDF = scorer.ComputeIdf(document_freqs.size());
+        postings.clear();
+        for (const auto [document_id, TF] : document_freqs) {
+            const double impact = quantization_step_ > 0.0 ? std::round(scorer.Score(TF, IDF, 0) / quantization_step_) : 0.0;
+            postings.emplace_back(static_cast<uint16_t>(std::clamp(impact, 1.0, MAX_QUANTIZED_IMPACT)),
+                                  static_cast<uint32_t>(document_id));
+        }
+        std::sort(postings.begin(), postings.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second); });
+
+        terms_.emplace_back(word);
+        term_segment_offsets_.push_back(static_cast<uint32_t>(segments_.size()));
+        for (size_t i = 0; i < postings.size(); ++i) {
+            if (i == 0 || postings[i].first != postings[i - 1].first) {
+                segments_.push_back({ postings[i].first, static_cast<uint32_t>(document_ids_.size()) });
+            }
+            document_ids_.push_back(postings[i].second);
+        }
+    }
+    term_segment_offsets_.push_back(static_cast<uint32_t>(segments_.size()));
+    segments_.push_back({ 0, static_cast<uint32_t>(document_ids_.size()) });
+
+    if (!search_server.documents_.empty()) {
+        documents_.resize(search_server.documents_.rbegin()->first + 1);
+    }
+    for (const auto& [document_id, properties] : search_server.documents_) {
+        documents_[document_id] = { properties.rating, properties.status };
+    }
+}
+
+const std::vector<Document>& ImpactIndex::FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(context, raw_query, DocumentFilter::ByStatus(status));
+}
+
+const std::vector<Document>& ImpactIndex::FindTopDocuments(QueryContext& context, std::string_view raw_query) const {
+    return FindTopDocuments(context, raw_query, DocumentStatus::ACTUAL);
+}
+
+std::vector<Document> ImpactIndex::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(raw_query, DocumentFilter::ByStatus(status));
+}
+
+std::vector<Document> ImpactIndex::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+double ImpactIndex::GetQuantizationStep() const {
+    return quantization_step_;
+}
+
+size_t ImpactIndex::GetMemoryBytes() const {
+    size_t bytes = terms_.capacity() * sizeof(std::string);
+    for (const std::string& term : terms_) {
+        bytes += term.capacity() > std::string().capacity() ? term.capacity() + 1 : 0;
+    }
+    return bytes + term_segment_offsets_.capacity() * sizeof(uint32_t) + segments_.capacity() * sizeof(Segment)
+        + document_ids_.capacity() * sizeof(uint32_t) + documents_.capacity() * sizeof(Properties);
+}
+
+size_t ImpactIndex::FindTerm(std::string_view word) const {
+    const auto it = std::lower_bound(terms_.begin(), terms_.end(), word,
+        [](const std::string& term, std::string_view word) { return term < word; });
+    return it != terms_.end() && *it == word ? it - terms_.begin() : terms_.size();
+}
+
+// разбор упрощённого запроса: обязательные слова, шаблоны и исправление опечаток снимком не поддерживаются
+void ImpactIndex::ParseQuery(std::string_view raw_query, QueryContext& context) const {
+    METRICS_STAGE(MetricsStage::PARSE_QUERY);
+    context.plus_words.clear();
+    context.minus_words.clear();
+    SplitIntoWords(raw_query, context.words);
+    for (std::string_view word : context.words) {
+        const bool is_minus = word[0] == '-';
+        if (is_minus) {
+            word.remove_prefix(1);
+        }
+        if (word.empty() || word[0] == '-' || word[0] == '+') {
+            throw std::invalid_argument("Invalid query word for the impact index: "s + std::string(word));
+        }
+        (is_minus ? context.minus_words : context.plus_words).push_back(word);
+    }
+    std::sort(context.plus_words.begin(), context.plus_words.end());
+    context.plus_words.erase(std::unique(context.plus_words.begin(), context.plus_words.end()), context.plus_words.end());
+}
+
+// вклад сегмента одинаков для всех его документов, а их id возрастают, поэтому внутренний цикл -
+// прибавление константы к накопителям по возрастающим адресам; накопители меньше 2^31
+// при любом реалистичном числе слов запроса (не больше 2^15 вкладов по 2^16)
+void ImpactIndex::AccumulateScores(QueryContext& context) const {
+    auto& scores = context.impact_scores;
+    auto& dirty_blocks = context.impact_dirty_blocks;
+    // накопители контекста всегда обнулены: SelectTopDocuments очищает каждый помеченный блок
+    const size_t block_count = (documents_.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if (scores.size() < block_count * BLOCK_SIZE) {
+        scores.resize(block_count * BLOCK_SIZE, 0);
+        dirty_blocks.resize((block_count + 63) / 64, 0);
+    }
+
+    {
+        METRICS_STAGE(MetricsStage::POSTING_TRAVERSAL);
+        size_t postings_scanned = 0;
+        for (std::string_view word : context.plus_words) {
+            const size_t term = FindTerm(word);
+            if (term == terms_.size()) {
+                continue;
+            }
+            for (uint32_t segment = term_segment_offsets_[term]; segment < term_segment_offsets_[term + 1]; ++segment) {
+                const uint32_t impact = segments_[segment].impact;
+                const uint32_t end = segments_[segment + 1].begin;
+                for (uint32_t i = segments_[segment].begin; i < end; ++i) {
+                    const uint32_t document_id = document_ids_[i];
+                    scores[document_id] += impact;
+                    dirty_blocks[document_id / BLOCK_SIZE / 64] |= uint64_t{1} << (document_id / BLOCK_SIZE % 64);
+                }
+                postings_scanned += end - segments_[segment].begin;
+            }
+        }
+        METRICS_COUNT(MetricsCounter::POSTINGS_SCANNED, postings_scanned);
+    }
+
+    METRICS_STAGE(MetricsStage::MINUS_WORDS);
+    for (std::string_view word : context.minus_words) {
+        const size_t term = FindTerm(word);
+        if (term == terms_.size()) {
+            continue;
+        }
+        const uint32_t begin = segments_[term_segment_offsets_[term]].begin;
+        const uint32_t end = segments_[term_segment_offsets_[term + 1]].begin;
+        for (uint32_t i = begin; i < end; ++i) {
+            scores[document_ids_[i]] = 0;
+        }
+    }
+}
+
+// есть ли в блоке накопитель не меньше порога; на x86-64 - сравнением по четыре накопителя SSE2
+bool ImpactIndex::HasScoreAtLeast(const uint32_t* scores, uint32_t threshold) {
+#if defined(__SSE2__)
+    const __m128i bound = _mm_set1_epi32(static_cast<int>(threshold) - 1);
+    __m128i found = _mm_setzero_si128();
+    for (size_t i = 0; i < BLOCK_SIZE; i += 4) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(scores + i));
+        found = _mm_or_si128(found, _mm_cmpgt_epi32(block, bound));
+    }
+    return _mm_movemask_epi8(found) != 0;
+#else
+    return std::any_of(scores, scores + BLOCK_SIZE, [threshold](uint32_t score) { return score >= threshold; });
+#endif
+}
\ No newline at end of file
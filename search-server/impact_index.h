@@ -0,0 +1,158 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "document.h"
+#include "document_filter.h"
+#include "metrics.h"
+#include "query_context.h"
+#include "search_server.h"
+
+// неизменяемый снимок индекса сервера для ранжирования по TF-IDF целыми числами:
+// вклад TF * IDF каждой записи {слово, документ} вычислен заранее и квантован в 16-битное целое,
+// записи слова сгруппированы в сегменты с равным вкладом в порядке его убывания, а релевантность
+// накапливается в плотном массиве целых с индексом по id документа. Поддерживаются плюс- и минус-слова;
+// изменения сервера после построения снимка в нём не отражаются
+class ImpactIndex {
+public:
+    explicit ImpactIndex(const SearchServer& search_server);
+
+    // результат хранится в контексте и остаётся действительным до следующего запроса с этим контекстом
+    template <typename DocumentPredicate>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query,
+                                                  DocumentPredicate document_predicate) const;
+
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentStatus status) const;
+
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    // релевантность единицы квантованного вклада: релевантность документа отличается
+    // от точной не больше чем на один шаг на каждое плюс-слово запроса
+    double GetQuantizationStep() const;
+
+    size_t GetMemoryBytes() const;
+
+private:
+    // сегмент - id документов с равным вкладом слова, от begin до begin следующего сегмента
+    struct Segment {
+        uint16_t impact;
+        uint32_t begin;
+    };
+
+    struct Properties {
+        int rating = 0;
+        DocumentStatus status = DocumentStatus::ACTUAL;
+    };
+
+    // накопители обнуляются и просматриваются блоками; блок помечается при первой записи в него
+    static const size_t BLOCK_SIZE = 64;
+
+    // номер слова в terms_ или terms_.size(), если слова нет
+    size_t FindTerm(std::string_view word) const;
+
+    void ParseQuery(std::string_view raw_query, QueryContext& context) const;
+
+    void AccumulateScores(QueryContext& context) const;
+
+    // отбор топ-5 по помеченным блокам накопителей с их обнулением
+    template <typename DocumentPredicate>
+    void SelectTopDocuments(QueryContext& context, DocumentPredicate& document_predicate) const;
+
+    static bool HasScoreAtLeast(const uint32_t* scores, uint32_t threshold);
+
+    // слова по возрастанию; сегменты слова i - [term_segment_offsets_[i], term_segment_offsets_[i + 1]),
+    // последний сегмент segments_ - ограничитель
+    std::vector<std::string> terms_;
+    std::vector<uint32_t> term_segment_offsets_;
+    std::vector<Segment> segments_;
+    std::vector<uint32_t> document_ids_;
+    // свойства документов с индексом по id
+    std::vector<Properties> documents_;
+    double quantization_step_ = 0.0;
+};
+
+template <typename DocumentPredicate>
+const std::vector<Document>& ImpactIndex::FindTopDocuments(QueryContext& context, std::string_view raw_query,
+                                                           DocumentPredicate document_predicate) const {
+    METRICS_COUNT(MetricsCounter::QUERIES, 1);
+    ParseQuery(raw_query, context);
+    AccumulateScores(context);
+    SelectTopDocuments(context, document_predicate);
+    METRICS_COUNT(MetricsCounter::EMPTY_RESULTS, context.documents.empty() ? 1 : 0);
+    return context.documents;
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ImpactIndex::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    QueryContext context;
+    return FindTopDocuments(context, raw_query, document_predicate);
+}
+
+// порог - наименьший накопитель среди отобранных: блок без накопителей не меньше порога пропускается
+// одной векторной проверкой; равный порогу накопитель может обойти отобранный по рейтингу
+template <typename DocumentPredicate>
+void ImpactIndex::SelectTopDocuments(QueryContext& context, DocumentPredicate& document_predicate) const {
+    METRICS_STAGE(MetricsStage::TOP_K);
+    // {накопитель, рейтинг, id} по убыванию накопителя, при равных - по убыванию рейтинга
+    std::array<std::tuple<uint32_t, int, int>, MAX_RESULT_DOCUMENT_COUNT> top;
+    size_t top_count = 0;
+    uint32_t threshold = 1;
+    auto& scores = context.impact_scores;
+    auto& dirty_blocks = context.impact_dirty_blocks;
+    for (size_t word_index = 0; word_index < dirty_blocks.size(); ++word_index) {
+        for (uint64_t word = dirty_blocks[word_index]; word != 0; word &= word - 1) {
+            size_t bit = 0;
+            while (((word >> bit) & 1) == 0) {
+                ++bit;
+            }
+            uint32_t* block = scores.data() + (word_index * 64 + bit) * BLOCK_SIZE;
+            if (HasScoreAtLeast(block, threshold)) {
+                for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+                    if (block[i] < threshold) {
+                        continue;
+                    }
+                    const int document_id = static_cast<int>((word_index * 64 + bit) * BLOCK_SIZE + i);
+                    const Properties& properties = documents_[document_id];
+                    if (!document_predicate(document_id, properties.status, properties.rating)) {
+                        continue;
+                    }
+                    const std::tuple<uint32_t, int, int> candidate{ block[i], properties.rating, document_id };
+                    const auto is_better = [](const auto& lhs, const auto& rhs) {
+                        return std::tie(std::get<0>(lhs), std::get<1>(lhs)) > std::tie(std::get<0>(rhs), std::get<1>(rhs));
+                    };
+                    if (top_count == MAX_RESULT_DOCUMENT_COUNT && !is_better(candidate, top[top_count - 1])) {
+                        continue;
+                    }
+                    size_t position = std::min(top_count, static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT - 1));
+                    for (; position > 0 && is_better(candidate, top[position - 1]); --position) {
+                        top[position] = top[position - 1];
+                    }
+                    top[position] = candidate;
+                    top_count = std::min(top_count + 1, static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+                    if (top_count == MAX_RESULT_DOCUMENT_COUNT) {
+                        threshold = std::get<0>(top[top_count - 1]);
+                    }
+                }
+            }
+            std::fill(block, block + BLOCK_SIZE, 0);
+        }
+        dirty_blocks[word_index] = 0;
+    }
+
+    context.documents.clear();
+    for (size_t i = 0; i < top_count; ++i) {
+        const auto [score, rating, document_id] = top[i];
+        context.documents.emplace_back(document_id, score * quantization_step_, rating);
+    }
+}
\ No newline at end of file
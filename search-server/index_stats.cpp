@@ -0,0 +1,30 @@
+#include "index_stats.h"
+
+size_t IndexStats::GetTotalBytes() const {
+    return term_dictionary_bytes + postings_bytes + champion_lists_bytes + trigram_index_bytes + forward_index_bytes + document_table_bytes + stop_words_bytes
+        + document_store_bytes + positional_index_bytes;
+}
+
+void PrintIndexStats(const IndexStats& stats) {
+    std::cout << "{ "s
+         << "term_count = "s << stats.term_count << ", "s
+         << "total_postings = "s << stats.total_postings << ", "s
+         << "average_posting_list_length = "s << stats.average_posting_list_length << ", "s
+         << "max_posting_list_length = "s << stats.max_posting_list_length << " }"s << std::endl;
+    std::cout << "{ "s
+         << "term_dictionary_bytes = "s << stats.term_dictionary_bytes << ", "s
+         << "postings_bytes = "s << stats.postings_bytes << ", "s
+         << "champion_lists_bytes = "s << stats.champion_lists_bytes << ", "s
+         << "trigram_index_bytes = "s << stats.trigram_index_bytes << ", "s
+         << "forward_index_bytes = "s << stats.forward_index_bytes << ", "s
+         << "document_table_bytes = "s << stats.document_table_bytes << ", "s
+         << "stop_words_bytes = "s << stats.stop_words_bytes << ", "s
+         << "document_store_bytes = "s << stats.document_store_bytes << ", "s
+         << "document_text_bytes = "s << stats.document_text_bytes << ", "s
+         << "positional_index_bytes = "s << stats.positional_index_bytes << ", "s
+         << "total_bytes = "s << stats.GetTotalBytes() << " }"s << std::endl;
+    for (size_t i = 0; i < stats.posting_list_length_histogram.size(); ++i) {
+        std::cout << "["s << (size_t{1} << i) << ", "s << (size_t{1} << (i + 1)) << "): "s
+             << stats.posting_list_length_histogram[i] << std::endl;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include <iostream>
+#include <vector>
+
+using namespace std::string_literals;
+
+// статистика индекса поискового сервера;
+// объём памяти оценивается по размерам узлов и строк контейнеров без учёта служебных данных аллокатора
+struct IndexStats {
+    // число слов в словаре и суммарное число записей {слово, документ}
+    size_t term_count = 0;
+    size_t total_postings = 0;
+    // средняя и максимальная длина списка документов одного слова
+    double average_posting_list_length = 0.0;
+    size_t max_posting_list_length = 0;
+
+    // память словаря слов, списков документов, списков лидеров слов, индекса триграмм,
+    // прямого индекса {документ -> слова}, таблицы свойств документов и стоп-слов, в байтах
+    size_t term_dictionary_bytes = 0;
+    size_t postings_bytes = 0;
+    size_t champion_lists_bytes = 0;
+    size_t trigram_index_bytes = 0;
+    size_t forward_index_bytes = 0;
+    size_t document_table_bytes = 0;
+    size_t stop_words_bytes = 0;
+    // память хранилища исходных текстов и суммарная длина хранимых текстов (0, если хранилище выключено);
+    // длина текстов в общий объём не входит
+    size_t document_store_bytes = 0;
+    size_t document_text_bytes = 0;
+    // память позиционного индекса (0, если он выключен)
+    size_t positional_index_bytes = 0;
+
+    // элемент i - число слов, длина списка документов которых лежит в диапазоне [2^i, 2^(i+1));
+    // нулевой элемент также учитывает слова с пустыми списками (после удаления документов)
+    std::vector<size_t> posting_list_length_histogram;
+
+    size_t GetTotalBytes() const;
+};
+
+void PrintIndexStats(const IndexStats& stats);
\ No newline at end of file
@@ -0,0 +1,126 @@
+// Генератор нагрузки: воспроизводит журнал запросов или синтетический поток запросов
+// против SearchServer с фиксированной частотой поступления по открытой схеме.
+// Отдельная цель сборки: load_generator/*.cpp, benchmark/zipf_corpus.cpp и все модули сервера, кроме main.cpp.
+// Параметры командной строки:
+//   --documents=PATH  документы по одному в строке (по умолчанию - синтетическая коллекция из --corpus-size документов)
+//   --stop-words=TEXT стоп-слова через пробел для коллекции из файла
+//   --log=PATH        журнал запросов по одному в строке, "-" - стандартный ввод
+//                     (по умолчанию - --query-count синтетических запросов)
+//   --qps=N --threads=N --duration-ms=N --interval-ms=N --seed=N
+// Результаты выводятся в stdout в формате JSON Lines: по строке на окно отчёта и итоговая строка
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../read_input_functions.h"
+#include "../search_server.h"
+#include "../benchmark/zipf_corpus.h"
+#include "query_replay.h"
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+struct LoadGeneratorOptions {
+    uint64_t seed = 42;
+    std::string documents_path;
+    std::string stop_words;
+    size_t corpus_size = 10'000;
+    std::string log_path;
+    size_t query_count = 10'000;
+    size_t max_query_word_count = 4;
+    double minus_probability = 0.1;
+    ReplayOptions replay;
+};
+
+std::vector<std::string> ReadLines(std::istream& input) {
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(input, line);) {
+        if (!line.empty()) {
+            lines.push_back(std::move(line));
+        }
+    }
+    return lines;
+}
+
+std::vector<std::string> ReadLinesFromFile(const std::string& path) {
+    std::ifstream input(path);
+    if (!input) {
+        throw std::invalid_argument("Can't open "s + path);
+    }
+    return ReadLines(input);
+}
+
+// журнал со стандартного ввода читается построчно через ReadLine до конца потока
+std::vector<std::string> ReadQueryLog(const std::string& path) {
+    if (path != "-"s) {
+        return ReadLinesFromFile(path);
+    }
+    std::vector<std::string> queries;
+    while (std::cin) {
+        std::string query = ReadLine();
+        if (!query.empty()) {
+            queries.push_back(std::move(query));
+        }
+    }
+    return queries;
+}
+
+LoadGeneratorOptions ParseOptions(int argc, char* argv[]) {
+    LoadGeneratorOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument = argv[i];
+        const auto separator = argument.find('=');
+        const std::string_view key = argument.substr(0, separator);
+        const std::string value(separator == argument.npos ? ""sv : argument.substr(separator + 1));
+        if (key == "--seed"sv) {
+            options.seed = std::stoull(value);
+        } else if (key == "--documents"sv) {
+            options.documents_path = value;
+        } else if (key == "--stop-words"sv) {
+            options.stop_words = value;
+        } else if (key == "--corpus-size"sv) {
+            options.corpus_size = std::stoull(value);
+        } else if (key == "--log"sv) {
+            options.log_path = value;
+        } else if (key == "--query-count"sv) {
+            options.query_count = std::stoull(value);
+        } else if (key == "--qps"sv) {
+            options.replay.target_qps = std::stod(value);
+        } else if (key == "--threads"sv) {
+            options.replay.thread_count = std::stoull(value);
+        } else if (key == "--duration-ms"sv) {
+            options.replay.duration = std::chrono::milliseconds(std::stoll(value));
+        } else if (key == "--interval-ms"sv) {
+            options.replay.report_interval = std::chrono::milliseconds(std::stoll(value));
+        } else {
+            throw std::invalid_argument("Unknown option: "s + std::string(argument));
+        }
+    }
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    const LoadGeneratorOptions options = ParseOptions(argc, argv);
+    CorpusOptions corpus_options;
+    corpus_options.seed = options.seed;
+    ZipfCorpusGenerator generator(corpus_options);
+
+    const bool synthetic_corpus = options.documents_path.empty();
+    const auto documents = synthetic_corpus
+        ? generator.GenerateDocuments(options.corpus_size)
+        : ReadLinesFromFile(options.documents_path);
+    SearchServer search_server(synthetic_corpus ? generator.GetStopWords() : options.stop_words);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {});
+    }
+
+    const auto queries = options.log_path.empty()
+        ? generator.GenerateQueries(options.query_count, options.max_query_word_count, options.minus_probability)
+        : ReadQueryLog(options.log_path);
+
+    const ReplayReport report = ReplayQueries(search_server, queries, options.replay);
+    PrintReplayReportJson(report, options.replay);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "query_replay.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+#include "../process_queries.h"
+
+using namespace std::string_literals;
+
+// показатели одного клиентского потока, сливаемые после завершения воспроизведения
+struct ClientStats {
+    std::vector<LatencyHistogram> window_latencies;
+    std::vector<size_t> window_errors;
+    std::chrono::nanoseconds max_schedule_lag{};
+    std::chrono::steady_clock::time_point last_completion;
+};
+
+ReplayReport ReplayQueries(const SearchServer& search_server, const std::vector<std::string>& queries,
+                           const ReplayOptions& options) {
+    using Clock = std::chrono::steady_clock;
+    if (queries.empty() || options.target_qps <= 0.0 || options.thread_count == 0
+        || options.report_interval.count() <= 0) {
+        throw std::invalid_argument("Replay needs queries, a positive rate, threads and report interval"s);
+    }
+    const double period_ns = 1e9 / options.target_qps;
+    const size_t request_count = static_cast<size_t>(
+        std::chrono::duration<double>(options.duration).count() * options.target_qps);
+    const auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(options.report_interval);
+
+    std::atomic<size_t> next_request = 0;
+    std::vector<ClientStats> client_stats(options.thread_count);
+    // запас времени на запуск потоков, чтобы первые запросы не отставали от расписания
+    const auto start_time = Clock::now() + std::chrono::milliseconds(10);
+
+    auto run_client = [&](ClientStats& stats) {
+        double checksum = 0.0;
+        for (size_t i = next_request++; i < request_count; i = next_request++) {
+            const auto scheduled_time = start_time
+                + std::chrono::nanoseconds(static_cast<int64_t>(i * period_ns));
+            std::this_thread::sleep_until(scheduled_time);
+            stats.max_schedule_lag = std::max(stats.max_schedule_lag,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - scheduled_time));
+
+            bool failed = false;
+            try {
+                for (const Document& document : ProcessQuery(search_server, queries[i % queries.size()])) {
+                    checksum += document.relevance;
+                }
+            } catch (const std::exception&) {
+                // одна некорректная строка журнала не должна останавливать весь прогон
+                failed = true;
+            }
+
+            const auto completion_time = Clock::now();
+            const size_t window = (completion_time - start_time) / interval;
+            if (window >= stats.window_latencies.size()) {
+                stats.window_latencies.resize(window + 1);
+                stats.window_errors.resize(window + 1);
+            }
+            if (failed) {
+                ++stats.window_errors[window];
+            } else {
+                stats.window_latencies[window].Record(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(completion_time - scheduled_time).count());
+            }
+            stats.last_completion = completion_time;
+        }
+        // результат нужен, чтобы компилятор не выбросил обработку запросов
+        if (checksum < 0.0) {
+            std::cerr << checksum << std::endl;
+        }
+    };
+
+    std::vector<std::thread> clients;
+    clients.reserve(options.thread_count);
+    for (ClientStats& stats : client_stats) {
+        clients.emplace_back(run_client, std::ref(stats));
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+
+    ReplayReport report;
+    auto finish_time = start_time;
+    for (const ClientStats& stats : client_stats) {
+        if (report.windows.size() < stats.window_latencies.size()) {
+            report.windows.resize(stats.window_latencies.size());
+        }
+        for (size_t window = 0; window < stats.window_latencies.size(); ++window) {
+            report.windows[window].latencies.Merge(stats.window_latencies[window]);
+            report.windows[window].errors += stats.window_errors[window];
+        }
+        report.max_schedule_lag = std::max(report.max_schedule_lag, stats.max_schedule_lag);
+        finish_time = std::max(finish_time, stats.last_completion);
+    }
+    const double interval_seconds = std::chrono::duration<double>(interval).count();
+    for (ReplayWindow& window : report.windows) {
+        window.completed = window.latencies.GetCount();
+        window.achieved_qps = window.completed / interval_seconds;
+        report.latencies.Merge(window.latencies);
+        report.errors += window.errors;
+    }
+    report.completed = report.latencies.GetCount();
+    const double elapsed_seconds = std::chrono::duration<double>(finish_time - start_time).count();
+    report.achieved_qps = elapsed_seconds > 0.0 ? report.completed / elapsed_seconds : 0.0;
+    return report;
+}
+
+static void PrintLatenciesJson(const LatencyHistogram& latencies, std::ostream& out) {
+    out << "\"p50_ns\": "s << latencies.GetPercentile(0.5) << ", "s
+        << "\"p99_ns\": "s << latencies.GetPercentile(0.99) << ", "s
+        << "\"p999_ns\": "s << latencies.GetPercentile(0.999) << ", "s
+        << "\"max_ns\": "s << latencies.GetMax();
+}
+
+void PrintReplayReportJson(const ReplayReport& report, const ReplayOptions& options, std::ostream& out) {
+    const double interval_seconds = std::chrono::duration<double>(options.report_interval).count();
+    for (size_t i = 0; i < report.windows.size(); ++i) {
+        const ReplayWindow& window = report.windows[i];
+        out << "{\"window_start_s\": "s << i * interval_seconds << ", "s
+            << "\"completed\": "s << window.completed << ", "s
+            << "\"errors\": "s << window.errors << ", "s
+            << "\"achieved_qps\": "s << window.achieved_qps << ", "s;
+        PrintLatenciesJson(window.latencies, out);
+        out << "}"s << std::endl;
+    }
+    out << "{\"summary\": true, "s
+        << "\"target_qps\": "s << options.target_qps << ", "s
+        << "\"threads\": "s << options.thread_count << ", "s
+        << "\"completed\": "s << report.completed << ", "s
+        << "\"errors\": "s << report.errors << ", "s
+        << "\"achieved_qps\": "s << report.achieved_qps << ", "s
+        << "\"max_schedule_lag_ns\": "s << report.max_schedule_lag.count() << ", "s;
+    PrintLatenciesJson(report.latencies, out);
+    out << "}"s << std::endl;
+}
\ No newline at end of file
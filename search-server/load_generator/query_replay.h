@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../metrics.h"
+#include "../search_server.h"
+
+// параметры воспроизведения потока запросов
+struct ReplayOptions {
+    // целевая частота поступления запросов в секунду
+    double target_qps = 1'000.0;
+    size_t thread_count = 4;
+    std::chrono::milliseconds duration{ 10'000 };
+    // длина окна, за которое выводятся достигнутая частота и перцентили задержек
+    std::chrono::milliseconds report_interval{ 1'000 };
+};
+
+// показатели запросов, завершившихся в одном окне
+struct ReplayWindow {
+    size_t completed = 0;
+    // запросы, обработка которых завершилась исключением (например, некорректный запрос из журнала);
+    // в completed и задержки они не входят
+    size_t errors = 0;
+    double achieved_qps = 0.0;
+    // задержка от запланированного момента отправки до завершения, в наносекундах
+    LatencyHistogram latencies;
+};
+
+struct ReplayReport {
+    std::vector<ReplayWindow> windows;
+    size_t completed = 0;
+    size_t errors = 0;
+    double achieved_qps = 0.0;
+    // наибольшее отставание начала обработки от расписания
+    std::chrono::nanoseconds max_schedule_lag{};
+    LatencyHistogram latencies;
+};
+
+// воспроизведение запросов по открытой схеме: запрос i планируется на момент i / target_qps
+// независимо от завершения предыдущих, а задержка отсчитывается от запланированного момента.
+// Поэтому перегрузка сервера видна как рост задержек, а не маскируется снижением частоты
+// отправки (coordinated omission). Запросы берутся из queries по кругу; исключение при обработке
+// запроса не прерывает воспроизведение, а учитывается в числе ошибок окна
+ReplayReport ReplayQueries(const SearchServer& search_server, const std::vector<std::string>& queries,
+                           const ReplayOptions& options);
+
+// вывод в формате JSON Lines: по строке на окно и итоговая строка
+void PrintReplayReportJson(const ReplayReport& report, const ReplayOptions& options, std::ostream& out = std::cout);
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include <chrono>
 #include <iostream>
+#include <string>
+#include <string_view>
 
 using namespace std;
 using namespace chrono;
@@ -13,7 +15,7 @@ using namespace literals;
 
 class LogDuration {
 public:
-    LogDuration(const std::string& id) : id_(id) {
+    LogDuration(std::string_view id) : id_(id) {
     }
 
     ~LogDuration() {
@@ -52,7 +52,7 @@ int main() {
     for (const Document& document : search_server.FindTopDocuments(
         execution::par,
         "curly nasty cat"s,
-        [](int document_id, DocumentStatus status, int rating) {
+        [](int document_id, DocumentStatus, int) {
             return document_id % 2 == 0; })) {
         PrintDocument(document);
     }
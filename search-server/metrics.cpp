@@ -0,0 +1,226 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std::string_literals;
+
+std::string_view GetMetricsStageName(MetricsStage stage) {
+    static const std::array<std::string_view, METRICS_STAGE_COUNT> names = {
+        "parse_query", "posting_traversal", "minus_words", "top_k", "match_document", "add_document", "remove_document"
+    };
+    return names[static_cast<size_t>(stage)];
+}
+
+std::string_view GetMetricsCounterName(MetricsCounter counter) {
+    static const std::array<std::string_view, METRICS_COUNTER_COUNT> names = {
+        "queries", "empty_results", "postings_scanned", "postings_rejected", "documents_added", "documents_removed",
+        "champion_hits", "champion_fallbacks", "approximate_results", "document_store_cache_hits",
+        "document_store_cache_misses"
+    };
+    return names[static_cast<size_t>(counter)];
+}
+
+// номер старшего установленного бита
+static int GetHighestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+size_t LatencyHistogram::GetBucketIndex(uint64_t value) {
+    const uint64_t max_value = (uint64_t{1} << MAX_VALUE_BITS) - 1;
+    value = std::min(value, max_value);
+    if (value < (uint64_t{2} << SUB_BUCKET_BITS)) {
+        return value;
+    }
+    // value >> shift лежит в [16, 32): старшие 5 бит значения
+    const int shift = GetHighestBit(value) - SUB_BUCKET_BITS;
+    return (static_cast<size_t>(shift) << SUB_BUCKET_BITS) + (value >> shift);
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t index) {
+    if (index < (size_t{2} << SUB_BUCKET_BITS)) {
+        return index;
+    }
+    const int shift = static_cast<int>(index >> SUB_BUCKET_BITS) - 1;
+    const uint64_t mantissa = (index & ((size_t{1} << SUB_BUCKET_BITS) - 1)) + (uint64_t{1} << SUB_BUCKET_BITS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value) {
+    ++buckets_[GetBucketIndex(value)];
+    ++count_;
+    sum_ += value;
+    max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+uint64_t LatencyHistogram::GetPercentile(double quantile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(quantile * count_ + 0.5));
+    uint64_t accumulated = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        accumulated += buckets_[i];
+        if (accumulated >= rank) {
+            return std::min(GetBucketUpperBound(i), max_);
+        }
+    }
+    return max_;
+}
+
+double LatencyHistogram::GetMean() const {
+    return count_ == 0 ? 0.0 : sum_ * 1.0 / count_;
+}
+
+// блок показателей одного потока: пишет только поток-владелец, поэтому достаточно
+// атомарных операций с relaxed-упорядочиванием, а чтение из CollectMetrics не блокирует запись
+struct ThreadMetrics {
+    struct StageLatencies {
+        std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKET_COUNT> buckets;
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+    };
+    std::array<StageLatencies, METRICS_STAGE_COUNT> stages;
+    std::array<std::atomic<uint64_t>, METRICS_COUNTER_COUNT> counters;
+};
+
+// блоки потоков живут до конца программы, чтобы показатели завершившихся потоков не терялись
+struct ThreadMetricsRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadMetrics>> threads;
+};
+
+static ThreadMetricsRegistry& GetRegistry() {
+    static ThreadMetricsRegistry registry;
+    return registry;
+}
+
+static ThreadMetrics& GetThreadMetrics() {
+    // блокировка берётся только при первой записи из нового потока
+    thread_local ThreadMetrics* thread_metrics = [] {
+        auto& registry = GetRegistry();
+        std::lock_guard guard(registry.mutex);
+        registry.threads.push_back(std::make_unique<ThreadMetrics>());
+        return registry.threads.back().get();
+    }();
+    return *thread_metrics;
+}
+
+static void IncrementRelaxed(std::atomic<uint64_t>& value, uint64_t delta) {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void RecordStageDuration(MetricsStage stage, uint64_t nanoseconds) {
+    auto& latencies = GetThreadMetrics().stages[static_cast<size_t>(stage)];
+    IncrementRelaxed(latencies.buckets[LatencyHistogram::GetBucketIndex(nanoseconds)], 1);
+    IncrementRelaxed(latencies.count, 1);
+    IncrementRelaxed(latencies.sum, nanoseconds);
+    if (nanoseconds > latencies.max.load(std::memory_order_relaxed)) {
+        latencies.max.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+void AddToCounter(MetricsCounter counter, uint64_t value) {
+    IncrementRelaxed(GetThreadMetrics().counters[static_cast<size_t>(counter)], value);
+}
+
+MetricsSnapshot CollectMetrics() {
+    MetricsSnapshot snapshot;
+    auto& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    for (const auto& thread_metrics : registry.threads) {
+        for (size_t stage = 0; stage < METRICS_STAGE_COUNT; ++stage) {
+            const auto& latencies = thread_metrics->stages[stage];
+            LatencyHistogram& histogram = snapshot.stage_latencies[stage];
+            for (size_t i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+                histogram.buckets_[i] += latencies.buckets[i].load(std::memory_order_relaxed);
+            }
+            histogram.count_ += latencies.count.load(std::memory_order_relaxed);
+            histogram.sum_ += latencies.sum.load(std::memory_order_relaxed);
+            histogram.max_ = std::max(histogram.max_, latencies.max.load(std::memory_order_relaxed));
+        }
+        for (size_t counter = 0; counter < METRICS_COUNTER_COUNT; ++counter) {
+            snapshot.counters[counter] += thread_metrics->counters[counter].load(std::memory_order_relaxed);
+        }
+    }
+    return snapshot;
+}
+
+// сброс не синхронизирован с записью: замеры, идущие одновременно со сбросом, могут частично сохраниться
+void ResetMetrics() {
+    auto& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    for (const auto& thread_metrics : registry.threads) {
+        for (auto& latencies : thread_metrics->stages) {
+            for (auto& bucket : latencies.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            latencies.count.store(0, std::memory_order_relaxed);
+            latencies.sum.store(0, std::memory_order_relaxed);
+            latencies.max.store(0, std::memory_order_relaxed);
+        }
+        for (auto& counter : thread_metrics->counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void PrintMetrics(const MetricsSnapshot& metrics, std::ostream& out) {
+    for (size_t stage = 0; stage < METRICS_STAGE_COUNT; ++stage) {
+        const LatencyHistogram& histogram = metrics.stage_latencies[stage];
+        out << GetMetricsStageName(static_cast<MetricsStage>(stage)) << ": "s
+            << "count = "s << histogram.GetCount() << ", "s
+            << "mean = "s << histogram.GetMean() << " ns, "s
+            << "p50 = "s << histogram.GetPercentile(0.5) << " ns, "s
+            << "p99 = "s << histogram.GetPercentile(0.99) << " ns, "s
+            << "p999 = "s << histogram.GetPercentile(0.999) << " ns, "s
+            << "max = "s << histogram.GetMax() << " ns"s << std::endl;
+    }
+    for (size_t counter = 0; counter < METRICS_COUNTER_COUNT; ++counter) {
+        out << GetMetricsCounterName(static_cast<MetricsCounter>(counter)) << ": "s
+            << metrics.counters[counter] << std::endl;
+    }
+}
+
+void PrintMetricsJson(const MetricsSnapshot& metrics, std::ostream& out) {
+    out << "{\"stages\": {"s;
+    for (size_t stage = 0; stage < METRICS_STAGE_COUNT; ++stage) {
+        const LatencyHistogram& histogram = metrics.stage_latencies[stage];
+        out << (stage == 0 ? ""s : ", "s)
+            << "\""s << GetMetricsStageName(static_cast<MetricsStage>(stage)) << "\": {"s
+            << "\"count\": "s << histogram.GetCount() << ", "s
+            << "\"mean_ns\": "s << histogram.GetMean() << ", "s
+            << "\"p50_ns\": "s << histogram.GetPercentile(0.5) << ", "s
+            << "\"p99_ns\": "s << histogram.GetPercentile(0.99) << ", "s
+            << "\"p999_ns\": "s << histogram.GetPercentile(0.999) << ", "s
+            << "\"max_ns\": "s << histogram.GetMax() << "}"s;
+    }
+    out << "}, \"counters\": {"s;
+    for (size_t counter = 0; counter < METRICS_COUNTER_COUNT; ++counter) {
+        out << (counter == 0 ? ""s : ", "s)
+            << "\""s << GetMetricsCounterName(static_cast<MetricsCounter>(counter)) << "\": "s
+            << metrics.counters[counter];
+    }
+    out << "}}"s << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+
+// Инструментирование горячих путей сервера: гистограммы задержек этапов и счётчики событий.
+// Каждый поток пишет в собственный блок атомарных счётчиков без блокировок,
+// CollectMetrics суммирует блоки всех потоков по запросу.
+// При сборке с SEARCH_SERVER_DISABLE_METRICS макросы METRICS_STAGE и METRICS_COUNT
+// раскрываются в пустые выражения и не оставляют в коде ни одной инструкции.
+
+enum class MetricsStage {
+    PARSE_QUERY,
+    POSTING_TRAVERSAL,
+    MINUS_WORDS,
+    TOP_K,
+    MATCH_DOCUMENT,
+    ADD_DOCUMENT,
+    REMOVE_DOCUMENT,
+    COUNT
+};
+
+enum class MetricsCounter {
+    QUERIES,
+    EMPTY_RESULTS,
+    // записи списков документов, проверенные предикатом или фильтром, и отвергнутые им
+    POSTINGS_SCANNED,
+    POSTINGS_REJECTED,
+    DOCUMENTS_ADDED,
+    DOCUMENTS_REMOVED,
+    // запросы, выполненные по спискам лидеров слов, и запросы, для которых пришлось вернуться к полному обходу
+    CHAMPION_HITS,
+    CHAMPION_FALLBACKS,
+    // запросы с бюджетом, выданные приблизительно из-за его исчерпания
+    APPROXIMATE_RESULTS,
+    // обращения к распакованным блокам хранилища текстов, найденным в кеше и распакованным заново
+    DOCUMENT_STORE_CACHE_HITS,
+    DOCUMENT_STORE_CACHE_MISSES,
+    COUNT
+};
+
+const size_t METRICS_STAGE_COUNT = static_cast<size_t>(MetricsStage::COUNT);
+const size_t METRICS_COUNTER_COUNT = static_cast<size_t>(MetricsCounter::COUNT);
+
+std::string_view GetMetricsStageName(MetricsStage stage);
+
+std::string_view GetMetricsCounterName(MetricsCounter counter);
+
+struct MetricsSnapshot;
+
+// гистограмма задержек в наносекундах по схеме HDR: значения до 32 хранятся точно,
+// каждый следующий интервал [2^k, 2^(k+1)) разбит на 16 равных частей,
+// поэтому относительная погрешность перцентилей не превышает 1/16
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int MAX_VALUE_BITS = 40;
+    static const size_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+    static size_t GetBucketIndex(uint64_t value);
+
+    // наибольшее значение, попадающее в корзину
+    static uint64_t GetBucketUpperBound(size_t index);
+
+    void Record(uint64_t value);
+
+    void Merge(const LatencyHistogram& other);
+
+    // значение, не меньше которого доля quantile (от 0 до 1) записанных значений
+    uint64_t GetPercentile(double quantile) const;
+
+    uint64_t GetCount() const { return count_; }
+
+    uint64_t GetMax() const { return max_; }
+
+    double GetMean() const;
+
+private:
+    friend MetricsSnapshot CollectMetrics();
+
+    std::array<uint64_t, BUCKET_COUNT> buckets_ = {};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+struct MetricsSnapshot {
+    std::array<LatencyHistogram, METRICS_STAGE_COUNT> stage_latencies;
+    std::array<uint64_t, METRICS_COUNTER_COUNT> counters = {};
+};
+
+void RecordStageDuration(MetricsStage stage, uint64_t nanoseconds);
+
+void AddToCounter(MetricsCounter counter, uint64_t value);
+
+// сумма показателей всех потоков на момент вызова
+MetricsSnapshot CollectMetrics();
+
+void ResetMetrics();
+
+// вывод числа замеров, среднего, p50/p99/p999 и максимума по этапам и значений счётчиков
+void PrintMetrics(const MetricsSnapshot& metrics, std::ostream& out = std::cout);
+
+void PrintMetricsJson(const MetricsSnapshot& metrics, std::ostream& out = std::cout);
+
+// замер длительности этапа от создания объекта до выхода из области видимости
+class StageTimer {
+public:
+    explicit StageTimer(MetricsStage stage) : stage_(stage) {
+    }
+
+    ~StageTimer() {
+        const auto duration = std::chrono::steady_clock::now() - start_time_;
+        RecordStageDuration(stage_, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+private:
+    const MetricsStage stage_;
+    const std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+};
+
+#define METRICS_CONCAT_INTERNAL(X, Y) X##Y
+#define METRICS_CONCAT(X, Y) METRICS_CONCAT_INTERNAL(X, Y)
+
+#ifdef SEARCH_SERVER_DISABLE_METRICS
+#define METRICS_STAGE(stage) ((void)0)
+#define METRICS_COUNT(counter, value) ((void)0)
+#else
+#define METRICS_STAGE(stage) StageTimer METRICS_CONCAT(stageTimer, __LINE__)(stage)
+#define METRICS_COUNT(counter, value) AddToCounter((counter), (value))
+#endif
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 #include <iostream>
+#include <iterator>
 #include <stack>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 // шаблонная структура для работы с парами итераторов
@@ -67,4 +71,86 @@ std::ostream& operator<<(std::ostream& out, const IteratorRange<Iterator>& range
 template <typename Container>
 auto Paginate(const Container& c, size_t page_size) {
     return Paginator(begin(c), end(c), page_size);
+}
+
+// ленивая разбивка на страницы: страница запрашивается у источника только при переходе к ней.
+// Источник - вызываемый объект page_source(cursor, page_size), возвращающий страницу с полями
+// documents и next_cursor (см. SearchPage); пустой курсор означает первую страницу,
+// пустой next_cursor - последнюю. Обход однопроходный, как у итератора ввода
+template <typename PageSource>
+class LazyPaginator {
+public:
+    using Page = std::decay_t<decltype(std::declval<PageSource&>()(std::string(), size_t{}))>;
+    using PageRange = IteratorRange<typename decltype(Page::documents)::const_iterator>;
+
+    class PageIterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = PageRange;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const PageRange*;
+        using reference = PageRange;
+
+        PageIterator() = default;
+
+        explicit PageIterator(const LazyPaginator* paginator)
+            : paginator_(paginator) {
+            Load(std::string());
+        }
+
+        PageRange operator*() const {
+            return { page_.documents.begin(), page_.documents.end() };
+        }
+
+        PageIterator& operator++() {
+            if (page_.next_cursor.empty()) {
+                paginator_ = nullptr;
+            } else {
+                Load(std::move(page_.next_cursor));
+            }
+            return *this;
+        }
+
+        // итераторы равны, только если оба достигли конца
+        bool operator==(const PageIterator& other) const {
+            return paginator_ == nullptr && other.paginator_ == nullptr;
+        }
+
+        bool operator!=(const PageIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        void Load(std::string cursor) {
+            page_ = paginator_->page_source_(cursor, paginator_->page_size_);
+            if (page_.documents.empty()) {
+                paginator_ = nullptr;
+            }
+        }
+
+        const LazyPaginator* paginator_ = nullptr;
+        Page page_;
+    };
+
+    LazyPaginator(PageSource page_source, size_t page_size)
+        : page_source_(std::move(page_source))
+        , page_size_(page_size) {
+    }
+
+    PageIterator begin() const {
+        return PageIterator(this);
+    }
+
+    PageIterator end() const {
+        return PageIterator();
+    }
+
+private:
+    mutable PageSource page_source_;
+    size_t page_size_;
+};
+
+template <typename PageSource>
+auto PaginateLazily(PageSource page_source, size_t page_size) {
+    return LazyPaginator<PageSource>(std::move(page_source), page_size);
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "positional_index.h"
+
+#include <algorithm>
+
+static void AppendVarint(std::vector<uint8_t>& bytes, uint32_t value) {
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+}
+
+template <typename Entries>
+static auto FindEntry(Entries& entries, int document_id) {
+    const auto it = std::lower_bound(entries.begin(), entries.end(), document_id,
+        [](const auto& entry, int document_id) { return entry.document_id < document_id; });
+    return it != entries.end() && it->document_id == document_id ? it : entries.end();
+}
+
+bool PositionalIndex::TermPositions::Decode(int document_id, std::vector<uint32_t>& positions) const {
+    positions.clear();
+    const auto entry_it = FindEntry(entries_, document_id);
+    if (entry_it == entries_.end()) {
+        return false;
+    }
+    const uint8_t* data = bytes_.data() + entry_it->offset;
+    const uint8_t* const data_end = data + entry_it->size;
+    uint32_t position = 0;
+    while (data != data_end) {
+        uint32_t delta = 0;
+        for (int shift = 0;; shift += 7) {
+            const uint8_t byte = *data++;
+            delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (byte < 0x80) {
+                break;
+            }
+        }
+        position += delta;
+        positions.push_back(position);
+    }
+    return true;
+}
+
+void PositionalIndex::Add(int document_id, const std::vector<std::pair<std::string_view, uint32_t>>& word_positions) {
+    // позиции каждого слова идут подряд и по возрастанию
+    auto sorted_positions = word_positions;
+    std::sort(sorted_positions.begin(), sorted_positions.end());
+    for (auto it = sorted_positions.begin(); it != sorted_positions.end();) {
+        const std::string_view word = it->first;
+        auto term_it = word_to_positions_.find(word);
+        if (term_it == word_to_positions_.end()) {
+            term_it = word_to_positions_.emplace(std::string(word), TermPositions{}).first;
+        }
+        TermPositions& term = term_it->second;
+        const size_t offset = term.bytes_.size();
+        uint32_t previous_position = 0;
+        for (; it != sorted_positions.end() && it->first == word; ++it) {
+            AppendVarint(term.bytes_, it->second - previous_position);
+            previous_position = it->second;
+        }
+        // документы обычно добавляются по возрастанию id, и запись дописывается в конец
+        const auto entry_it = std::lower_bound(term.entries_.begin(), term.entries_.end(), document_id,
+            [](const TermPositions::Entry& entry, int document_id) { return entry.document_id < document_id; });
+        term.entries_.insert(entry_it, { document_id, static_cast<uint32_t>(offset), static_cast<uint32_t>(term.bytes_.size() - offset) });
+    }
+}
+
+void PositionalIndex::Remove(int document_id, const std::vector<std::string_view>& words) {
+    for (std::string_view word : words) {
+        const auto term_it = word_to_positions_.find(word);
+        if (term_it == word_to_positions_.end()) {
+            continue;
+        }
+        TermPositions& term = term_it->second;
+        const auto entry_it = FindEntry(term.entries_, document_id);
+        if (entry_it == term.entries_.end()) {
+            continue;
+        }
+        term.dead_bytes_ += entry_it->size;
+        term.entries_.erase(entry_it);
+        if (term.entries_.empty()) {
+            word_to_positions_.erase(term_it);
+        } else if (term.dead_bytes_ * 2 > term.bytes_.size()) {
+            std::vector<uint8_t> bytes;
+            bytes.reserve(term.bytes_.size() - term.dead_bytes_);
+            for (TermPositions::Entry& entry : term.entries_) {
+                const size_t offset = bytes.size();
+                bytes.insert(bytes.end(), term.bytes_.begin() + entry.offset, term.bytes_.begin() + entry.offset + entry.size);
+                entry.offset = static_cast<uint32_t>(offset);
+            }
+            term.bytes_ = std::move(bytes);
+            term.dead_bytes_ = 0;
+        }
+    }
+}
+
+const PositionalIndex::TermPositions* PositionalIndex::Find(std::string_view word) const {
+    const auto term_it = word_to_positions_.find(word);
+    return term_it != word_to_positions_.end() ? &term_it->second : nullptr;
+}
+
+// вхождения перебираются по позициям первого слова; позиции остальных слов ищутся двоичным поиском:
+// для точной фразы - на заданном расстоянии, со slop - ближайшие после предыдущего слова,
+// что даёт самое короткое вхождение с этим началом
+bool PositionalIndex::MatchPhrase(const std::vector<std::vector<uint32_t>>& positions, const std::vector<PhraseWord>& words,
+                                  const QueryPhrase& phrase) {
+    const uint32_t first_offset = words[phrase.begin].offset;
+    const uint32_t phrase_length = words[phrase.end - 1].offset - first_offset;
+    for (const uint32_t start : positions[phrase.begin]) {
+        bool is_matched = true;
+        uint32_t previous_position = start;
+        for (uint32_t i = phrase.begin + 1; i < phrase.end; ++i) {
+            const auto& word_positions = positions[i];
+            if (phrase.slop == 0) {
+                if (!std::binary_search(word_positions.begin(), word_positions.end(), start + words[i].offset - first_offset)) {
+                    is_matched = false;
+                    break;
+                }
+                continue;
+            }
+            const auto it = std::upper_bound(word_positions.begin(), word_positions.end(), previous_position);
+            // у следующих начал ближайшие позиции слова не меньше, поэтому вхождений дальше нет
+            if (it == word_positions.end()) {
+                return false;
+            }
+            previous_position = *it;
+        }
+        if (phrase.slop == 0 ? is_matched : previous_position - start <= phrase_length + phrase.slop) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t PositionalIndex::GetMemoryBytes() const {
+    // узел дерева - три указателя и цвет сверх хранимой пары
+    size_t bytes = word_to_positions_.size() * (sizeof(std::pair<const std::string, TermPositions>) + 4 * sizeof(void*));
+    for (const auto& [word, term] : word_to_positions_) {
+        if (word.capacity() > std::string().capacity()) {
+            bytes += word.capacity() + 1;
+        }
+        bytes += term.entries_.capacity() * sizeof(TermPositions::Entry) + term.bytes_.capacity();
+    }
+    return bytes;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// слово фразы запроса и его отступ от начала фразы; стоп-слова занимают места, но в фразу не входят
+struct PhraseWord {
+    std::string_view word;
+    uint32_t offset;
+};
+
+// фраза запроса ("слово слово" или "слово слово"~N): слова [begin, end) общего списка слов фраз
+// и slop - на сколько слов вхождение может быть длиннее фразы (0 - точная фраза)
+struct QueryPhrase {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t slop;
+};
+
+// позиционный индекс для фразовых запросов: для каждого слова - записи документов в порядке id
+// со ссылками на позиции слова в тексте, закодированные разностями в varint в общем буфере байтов слова.
+// Хранится отдельно от списков документов, поэтому запросы без фраз его не читают
+class PositionalIndex {
+public:
+    // позиции одного слова во всех документах
+    class TermPositions {
+    public:
+        // позиции слова в документе по возрастанию; false, если слова в документе нет
+        bool Decode(int document_id, std::vector<uint32_t>& positions) const;
+
+    private:
+        friend class PositionalIndex;
+
+        struct Entry {
+            int document_id;
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        std::vector<Entry> entries_;
+        std::vector<uint8_t> bytes_;
+        // байты позиций удалённых документов: буфер уплотняется, когда их становится больше половины
+        size_t dead_bytes_ = 0;
+    };
+
+    // слова документа (без стоп-слов) с их номерами в тексте, стоп-слова учитываются в нумерации
+    void Add(int document_id, const std::vector<std::pair<std::string_view, uint32_t>>& word_positions);
+
+    void Remove(int document_id, const std::vector<std::string_view>& words);
+
+    // позиции слова или nullptr, если слова нет ни в одном документе
+    const TermPositions* Find(std::string_view word) const;
+
+    // есть ли вхождение фразы: positions[i] - позиции слова words[i] по возрастанию, i из [begin, end).
+    // Без slop слова стоят на тех же расстояниях, что и во фразе; со slop - идут в порядке фразы,
+    // а вхождение длиннее фразы не больше чем на slop слов
+    static bool MatchPhrase(const std::vector<std::vector<uint32_t>>& positions, const std::vector<PhraseWord>& words,
+                            const QueryPhrase& phrase);
+
+    size_t GetMemoryBytes() const;
+
+private:
+    std::map<std::string, TermPositions, std::less<>> word_to_positions_;
+};
\ No newline at end of file
@@ -1,5 +1,11 @@
 #include "process_queries.h"
 
+const std::vector<Document>& ProcessQuery(const SearchServer& search_server, std::string_view query) {
+    // у каждого рабочего потока свой набор буферов запроса
+    thread_local QueryContext context;
+    return search_server.FindTopDocuments(context, query);
+}
+
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
                                                   const std::vector<std::string>& queries) {
     
@@ -9,7 +15,33 @@ std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_ser
         queries.begin(), queries.end(),
         matched_documents.begin(),
         [&search_server](auto& query) {
-            return search_server.FindTopDocuments(query);
+            return ProcessQuery(search_server, query);
+        }
+        );
+    
+    return matched_documents;
+}
+
+std::vector<std::vector<Document>> ProcessQueriesBatched(const SearchServer& search_server,
+                                                         const std::vector<std::string>& queries) {
+    return search_server.FindTopDocumentsBatch(queries);
+}
+
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+                                                  const std::vector<std::string>& queries,
+                                                  RequestStats& request_stats) {
+    
+    std::vector<std::vector<Document>> matched_documents(queries.size());
+    std::transform(
+        std::execution::par,
+        queries.begin(), queries.end(),
+        matched_documents.begin(),
+        [&search_server, &request_stats](auto& query) {
+            const auto start_time = RequestStats::Clock::now();
+            auto documents = ProcessQuery(search_server, query);
+            const auto finish_time = RequestStats::Clock::now();
+            request_stats.Record(documents.size(), finish_time - start_time, finish_time);
+            return documents;
         }
         );
     
@@ -5,12 +5,29 @@
 #include <vector>
 
 #include "document.h"
+#include "request_stats.h"
 #include "search_server.h"
 
+// обработка одного запроса с буферами запроса текущего потока;
+// результат действителен до следующего вызова в этом же потоке
+const std::vector<Document>& ProcessQuery(const SearchServer& search_server, std::string_view query);
+
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
+// пакетный режим: списки документов слов, общих для нескольких запросов, обходятся один раз
+// (см. SearchServer::FindTopDocumentsBatch); результат совпадает с ProcessQueries
+std::vector<std::vector<Document>> ProcessQueriesBatched(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
+
+// то же с записью числа найденных документов и времени обработки каждого запроса в статистику
+std::vector<std::vector<Document>> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    RequestStats& request_stats);
+
 std::list<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+#include "positional_index.h"
+
+// набор переиспользуемых буферов для выполнения поисковых запросов:
+// контекст создаётся один раз на поток и передаётся в FindTopDocuments,
+// после «прогрева» запросы выполняются без выделений динамической памяти
+struct QueryContext {
+    std::vector<std::string_view> words;
+    std::vector<std::string_view> plus_words;
+    std::vector<std::string_view> minus_words;
+    // обязательные слова (+слово) входят и в plus_words
+    std::vector<std::string_view> required_words;
+    // фразы запроса и их слова (слова фраз входят и в обязательные слова), позиции слов фраз
+    // в позиционном индексе и их позиции в проверяемом документе
+    std::vector<PhraseWord> phrase_words;
+    std::vector<QueryPhrase> phrases;
+    std::vector<const PositionalIndex::TermPositions*> phrase_terms;
+    std::vector<std::vector<uint32_t>> phrase_positions;
+    // списки документов обязательных слов и {список документов, IDF} плюс-слов для пересечения списков
+    std::vector<const std::pmr::map<int, double>*> required_postings;
+    std::vector<std::pair<const std::pmr::map<int, double>*, double>> scored_postings;
+    std::vector<std::pair<int, double>> document_to_relevance;
+    std::vector<int> excluded_document_ids;
+    // id документов из списков лидеров слов короткого запроса
+    std::vector<int> candidate_ids;
+    // номера слов словаря - кандидатов в исправление опечатки
+    std::vector<uint32_t> term_candidates;
+    // плотный массив целочисленных накопителей релевантности ImpactIndex и битовая карта его помеченных блоков
+    std::vector<uint32_t> impact_scores;
+    std::vector<uint64_t> impact_dirty_blocks;
+    std::vector<Document> documents;
+};
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include "query_explanation.h"
+
+void PrintQueryExplanation(const QueryExplanation& explanation, std::ostream& out) {
+    for (const TermExplanation& term : explanation.plus_terms) {
+        out << "+"s << term.word << ": "s
+            << "posting_count = "s << term.posting_count << ", "s
+            << "idf = "s << term.idf << ", "s
+            << "postings_scanned = "s << term.postings_scanned << ", "s
+            << "postings_rejected = "s << term.postings_rejected << std::endl;
+    }
+    for (const TermExplanation& term : explanation.minus_terms) {
+        out << "-"s << term.word << ": "s
+            << "posting_count = "s << term.posting_count << std::endl;
+    }
+    out << "{ "s
+        << "postings_scanned = "s << explanation.postings_scanned << ", "s
+        << "postings_rejected = "s << explanation.postings_rejected << ", "s
+        << "documents_scored = "s << explanation.documents_scored << ", "s
+        << "documents_excluded = "s << explanation.documents_excluded << " }"s << std::endl;
+    out << "{ "s
+        << "parse = "s << explanation.parse_duration.count() << " ns, "s
+        << "posting_traversal = "s << explanation.posting_traversal_duration.count() << " ns, "s
+        << "minus_words = "s << explanation.minus_words_duration.count() << " ns, "s
+        << "top_k = "s << explanation.top_k_duration.count() << " ns }"s << std::endl;
+    for (const Document& document : explanation.documents) {
+        out << "{ "s
+            << "document_id = "s << document.id << ", "s
+            << "relevance = "s << document.relevance << ", "s
+            << "rating = "s << document.rating << " }"s << std::endl;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "document.h"
+
+using namespace std::string_literals;
+
+// сведения об одном слове запроса
+struct TermExplanation {
+    std::string word;
+    // длина списка документов слова (0, если слова нет в индексе)
+    size_t posting_count = 0;
+    // для минус-слов IDF и счётчики проверок не заполняются
+    double idf = 0.0;
+    // записи списка, проверенные предикатом или фильтром, и отвергнутые им
+    size_t postings_scanned = 0;
+    size_t postings_rejected = 0;
+};
+
+// разбор выполнения запроса, возвращаемый SearchServer::ExplainTopDocuments
+struct QueryExplanation {
+    std::vector<TermExplanation> plus_terms;
+    std::vector<TermExplanation> minus_terms;
+
+    // суммы по плюс-словам
+    size_t postings_scanned = 0;
+    size_t postings_rejected = 0;
+    // документы, получившие релевантность, и исключённые из них минус-словами
+    size_t documents_scored = 0;
+    size_t documents_excluded = 0;
+
+    // время этапов: разбор запроса, обход списков документов плюс-слов,
+    // исключение документов минус-слов и отбор топ-5
+    std::chrono::nanoseconds parse_duration{};
+    std::chrono::nanoseconds posting_traversal_duration{};
+    std::chrono::nanoseconds minus_words_duration{};
+    std::chrono::nanoseconds top_k_duration{};
+
+    // та же выдача, что и у FindTopDocuments с теми же аргументами
+    std::vector<Document> documents;
+};
+
+void PrintQueryExplanation(const QueryExplanation& explanation, std::ostream& out = std::cout);
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "remove_duplicates.h"
 
-void RemoveDuplicates(SearchServer& search_server) {
+void RemoveDuplicates(SearchServer& search_server, std::ostream& out) {
     std::map<std::set<std::string>, int> words_to_id;
     std::vector<int> ids_to_delete;
     // формирование словаря words_to_id
@@ -9,7 +9,7 @@ void RemoveDuplicates(SearchServer& search_server) {
         
         // заполнение множества слов документа
         for (const auto& word_frequencies : search_server.GetWordFrequencies(document_id)) {
-            document_words.insert(word_frequencies.first);
+            document_words.insert(std::string(word_frequencies.first));
         }
         
         // формирование пары {слова_документа, id_документа} c проверкой наличия в словаре дубликата
@@ -22,7 +22,7 @@ void RemoveDuplicates(SearchServer& search_server) {
         }
     }
     for (const int duplicate_id : ids_to_delete) {
-        std::cout << "Found duplicate document id "s << duplicate_id << std::endl;
+        out << "Found duplicate document id "s << duplicate_id << std::endl;
         search_server.RemoveDocument(duplicate_id);
     }
 }
\ No newline at end of file
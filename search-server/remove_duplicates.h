@@ -8,4 +8,6 @@
 
 using namespace std::string_literals;
 
-void RemoveDuplicates(SearchServer& search_server);
\ No newline at end of file
+// удаление документов с совпадающим набором слов (остаётся документ с меньшим id);
+// id удалённых документов выводятся в поток out
+void RemoveDuplicates(SearchServer& search_server, std::ostream& out = std::cout);
\ No newline at end of file
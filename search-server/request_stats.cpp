@@ -0,0 +1,147 @@
+#include "request_stats.h"
+
+#include <algorithm>
+#include <thread>
+
+RequestStats::RequestStats()
+    : windows_{ SlidingWindow(10, std::chrono::milliseconds(100)),
+                SlidingWindow(60, std::chrono::seconds(1)),
+                SlidingWindow(1440, std::chrono::minutes(1)) } {
+}
+
+void RequestStats::Record(size_t result_count, std::chrono::nanoseconds latency, Clock::time_point now) {
+    const uint64_t latency_ns = std::max<int64_t>(latency.count(), 0);
+    for (SlidingWindow& window : windows_) {
+        window.Record(result_count, latency_ns, now);
+    }
+}
+
+RequestWindowStats RequestStats::GetStats(StatsWindow window, Clock::time_point now) const {
+    return windows_[static_cast<size_t>(window)].GetStats(now);
+}
+
+size_t RequestStats::GetLatencyBucket(uint64_t latency_ns) {
+    size_t bucket = 0;
+    while (latency_ns > 1 && bucket + 1 < LATENCY_BUCKET_COUNT) {
+        latency_ns >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+RequestStats::SlidingWindow::SlidingWindow(size_t slot_count, std::chrono::nanoseconds slot_duration)
+    : slots_(slot_count)
+    , slot_duration_(slot_duration) {
+}
+
+int64_t RequestStats::SlidingWindow::GetEpoch(Clock::time_point now) const {
+    return now.time_since_epoch() / slot_duration_;
+}
+
+RequestStats::Slot* RequestStats::SlidingWindow::AcquireSlot(int64_t epoch) {
+    Slot& slot = slots_[epoch % static_cast<int64_t>(slots_.size())];
+    while (true) {
+        int64_t slot_epoch = slot.epoch.load(std::memory_order_acquire);
+        if (slot_epoch == epoch) {
+            // интервал перепроверяется после регистрации писателя: иначе ячейку могли обнулить
+            // для следующего круга между чтением номера и добавлением, и запрос попал бы не в тот интервал
+            slot.writer_count.fetch_add(1, std::memory_order_seq_cst);
+            if (slot.epoch.load(std::memory_order_seq_cst) == epoch) {
+                return &slot;
+            }
+            slot.writer_count.fetch_sub(1, std::memory_order_release);
+            continue;
+        }
+        if (slot_epoch > epoch) {
+            // запись запоздала настолько, что её ячейка уже занята более новым интервалом
+            return nullptr;
+        }
+        if (slot_epoch == RESETTING_EPOCH) {
+            // обнуление занимает несколько десятков операций и случается раз за интервал ячейки
+            std::this_thread::yield();
+            continue;
+        }
+        if (slot.epoch.compare_exchange_weak(slot_epoch, RESETTING_EPOCH, std::memory_order_seq_cst)) {
+            // писатели прежнего интервала дописывают несколько счётчиков; их запросы вне окна и обнуляются
+            while (slot.writer_count.load(std::memory_order_seq_cst) != 0) {
+                std::this_thread::yield();
+            }
+            slot.request_count.store(0, std::memory_order_relaxed);
+            slot.result_count.store(0, std::memory_order_relaxed);
+            slot.empty_result_count.store(0, std::memory_order_relaxed);
+            slot.latency_sum_ns.store(0, std::memory_order_relaxed);
+            slot.max_latency_ns.store(0, std::memory_order_relaxed);
+            for (auto& bucket : slot.latency_buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            slot.writer_count.store(1, std::memory_order_relaxed);
+            slot.epoch.store(epoch, std::memory_order_release);
+            return &slot;
+        }
+    }
+}
+
+void RequestStats::SlidingWindow::Record(size_t result_count, uint64_t latency_ns, Clock::time_point now) {
+    Slot* slot = AcquireSlot(GetEpoch(now));
+    if (!slot) {
+        return;
+    }
+    slot->request_count.fetch_add(1, std::memory_order_relaxed);
+    slot->result_count.fetch_add(result_count, std::memory_order_relaxed);
+    if (result_count == 0) {
+        slot->empty_result_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot->latency_sum_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+    slot->latency_buckets[GetLatencyBucket(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max_latency = slot->max_latency_ns.load(std::memory_order_relaxed);
+    while (latency_ns > max_latency
+           && !slot->max_latency_ns.compare_exchange_weak(max_latency, latency_ns, std::memory_order_relaxed)) {
+    }
+    // обнуление ячейки ждёт, пока все добавления завершатся
+    slot->writer_count.fetch_sub(1, std::memory_order_release);
+}
+
+// чтение не блокирует запись: показатели ячейки, обновляемой во время чтения, могут быть неполными
+RequestWindowStats RequestStats::SlidingWindow::GetStats(Clock::time_point now) const {
+    const int64_t last_epoch = GetEpoch(now);
+    const int64_t first_epoch = last_epoch - static_cast<int64_t>(slots_.size()) + 1;
+    RequestWindowStats stats;
+    uint64_t latency_sum_ns = 0;
+    std::array<uint64_t, LATENCY_BUCKET_COUNT> latency_buckets = {};
+    for (const Slot& slot : slots_) {
+        const int64_t slot_epoch = slot.epoch.load(std::memory_order_acquire);
+        if (slot_epoch < 0 || slot_epoch < first_epoch || slot_epoch > last_epoch) {
+            continue;
+        }
+        stats.request_count += slot.request_count.load(std::memory_order_relaxed);
+        stats.result_count += slot.result_count.load(std::memory_order_relaxed);
+        stats.empty_result_count += slot.empty_result_count.load(std::memory_order_relaxed);
+        latency_sum_ns += slot.latency_sum_ns.load(std::memory_order_relaxed);
+        stats.max_latency_ns = std::max(stats.max_latency_ns, slot.max_latency_ns.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < LATENCY_BUCKET_COUNT; ++i) {
+            latency_buckets[i] += slot.latency_buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    if (stats.request_count == 0) {
+        return stats;
+    }
+    stats.empty_result_rate = stats.empty_result_count * 1.0 / stats.request_count;
+    stats.requests_per_second = stats.request_count
+        / std::chrono::duration<double>(slot_duration_ * slots_.size()).count();
+    stats.mean_latency_ns = latency_sum_ns * 1.0 / stats.request_count;
+
+    const auto percentile = [&](double quantile) {
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(quantile * stats.request_count + 0.5));
+        uint64_t accumulated = 0;
+        for (size_t i = 0; i < LATENCY_BUCKET_COUNT; ++i) {
+            accumulated += latency_buckets[i];
+            if (accumulated >= rank) {
+                return std::min((uint64_t{2} << i) - 1, stats.max_latency_ns);
+            }
+        }
+        return stats.max_latency_ns;
+    };
+    stats.p50_latency_ns = percentile(0.5);
+    stats.p99_latency_ns = percentile(0.99);
+    return stats;
+}
\ No newline at end of file
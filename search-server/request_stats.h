@@ -0,0 +1,89 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// потокобезопасная статистика запросов в скользящих окнах реального времени:
+// последняя секунда (10 ячеек по 100 мс), минута (60 ячеек по 1 с) и сутки (1440 ячеек по 1 мин).
+// Ячейки образуют кольцо фиксированного размера, поэтому память не зависит от частоты запросов;
+// запись выполняется атомарными операциями из любого числа потоков и ждёт только обнуления ячейки
+// при смене интервала, поэтому каждый запрос учитывается ровно в своём интервале
+
+enum class StatsWindow {
+    SECOND,
+    MINUTE,
+    DAY
+};
+
+// показатели запросов за окно
+struct RequestWindowStats {
+    uint64_t request_count = 0;
+    uint64_t result_count = 0;
+    uint64_t empty_result_count = 0;
+    double empty_result_rate = 0.0;
+    double requests_per_second = 0.0;
+    double mean_latency_ns = 0.0;
+    uint64_t max_latency_ns = 0;
+    // верхние границы степенных корзин задержек: оценка сверху с точностью до двух раз
+    uint64_t p50_latency_ns = 0;
+    uint64_t p99_latency_ns = 0;
+};
+
+class RequestStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RequestStats();
+
+    // момент времени передаётся явно для воспроизводимых тестов
+    void Record(size_t result_count, std::chrono::nanoseconds latency, Clock::time_point now = Clock::now());
+
+    // окно заканчивается текущей ячейкой: запросы старше длины окна не учитываются
+    RequestWindowStats GetStats(StatsWindow window, Clock::time_point now = Clock::now()) const;
+
+private:
+    // корзина i - задержки в диапазоне [2^i, 2^(i+1)) наносекунд, последняя также учитывает всё большее
+    static const size_t LATENCY_BUCKET_COUNT = 40;
+
+    struct Slot {
+        // номер интервала времени, к которому относятся счётчики ячейки
+        std::atomic<int64_t> epoch{ EMPTY_EPOCH };
+        // число писателей, добавляющих запрос в ячейку; обнуление ждёт их завершения
+        std::atomic<uint32_t> writer_count{ 0 };
+        std::atomic<uint64_t> request_count{ 0 };
+        std::atomic<uint64_t> result_count{ 0 };
+        std::atomic<uint64_t> empty_result_count{ 0 };
+        std::atomic<uint64_t> latency_sum_ns{ 0 };
+        std::atomic<uint64_t> max_latency_ns{ 0 };
+        std::array<std::atomic<uint64_t>, LATENCY_BUCKET_COUNT> latency_buckets{};
+    };
+
+    class SlidingWindow {
+    public:
+        SlidingWindow(size_t slot_count, std::chrono::nanoseconds slot_duration);
+
+        void Record(size_t result_count, uint64_t latency_ns, Clock::time_point now);
+
+        RequestWindowStats GetStats(Clock::time_point now) const;
+
+    private:
+        int64_t GetEpoch(Clock::time_point now) const;
+
+        // ячейка текущего интервала с зарегистрированным писателем, Record снимает регистрацию;
+        // при первом обращении в новом интервале ячейка обнуляется
+        Slot* AcquireSlot(int64_t epoch);
+
+        std::vector<Slot> slots_;
+        std::chrono::nanoseconds slot_duration_;
+    };
+
+    // ячейка ещё не использовалась либо обнуляется другим потоком
+    static const int64_t EMPTY_EPOCH = -1;
+    static const int64_t RESETTING_EPOCH = -2;
+
+    static size_t GetLatencyBucket(uint64_t latency_ns);
+
+    std::array<SlidingWindow, 3> windows_;
+};
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "roaring_bitmap.h"
+
+RoaringBitmap::RoaringBitmap(std::pmr::memory_resource* resource)
+    : containers_(resource) {
+}
+
+void RoaringBitmap::Add(uint32_t value) {
+    const uint16_t key = value >> 16;
+    const uint16_t low = value & 0xFFFF;
+    auto it = containers_.begin() + (FindContainer(key) - containers_.cbegin());
+    if (it == containers_.end() || it->key != key) {
+        it = containers_.insert(it, Container(containers_.get_allocator().resource()));
+        it->key = key;
+    }
+    Container& container = *it;
+    if (container.IsBitmap()) {
+        uint64_t& word = container.bits[low / 64];
+        const uint64_t mask = uint64_t{1} << (low % 64);
+        if (word & mask) {
+            return;
+        }
+        word |= mask;
+    } else {
+        auto pos = std::lower_bound(container.array.begin(), container.array.end(), low);
+        if (pos != container.array.end() && *pos == low) {
+            return;
+        }
+        container.array.insert(pos, low);
+    }
+    ++container.cardinality;
+    ++size_;
+    if (!container.IsBitmap() && container.cardinality > ARRAY_MAX_SIZE) {
+        ConvertToBitmap(container);
+    }
+}
+
+void RoaringBitmap::Remove(uint32_t value) {
+    const uint16_t key = value >> 16;
+    const uint16_t low = value & 0xFFFF;
+    auto it = containers_.begin() + (FindContainer(key) - containers_.cbegin());
+    if (it == containers_.end() || it->key != key) {
+        return;
+    }
+    Container& container = *it;
+    if (container.IsBitmap()) {
+        uint64_t& word = container.bits[low / 64];
+        const uint64_t mask = uint64_t{1} << (low % 64);
+        if (!(word & mask)) {
+            return;
+        }
+        word &= ~mask;
+    } else {
+        auto pos = std::lower_bound(container.array.begin(), container.array.end(), low);
+        if (pos == container.array.end() || *pos != low) {
+            return;
+        }
+        container.array.erase(pos);
+    }
+    --container.cardinality;
+    --size_;
+    if (container.cardinality == 0) {
+        containers_.erase(it);
+    } else if (container.IsBitmap() && container.cardinality <= ARRAY_MAX_SIZE) {
+        ConvertToArray(container);
+    }
+}
+
+bool RoaringBitmap::Contains(uint32_t value) const {
+    const uint16_t key = value >> 16;
+    const uint16_t low = value & 0xFFFF;
+    const auto it = FindContainer(key);
+    if (it == containers_.end() || it->key != key) {
+        return false;
+    }
+    if (it->IsBitmap()) {
+        return (it->bits[low / 64] >> (low % 64)) & 1;
+    }
+    return std::binary_search(it->array.begin(), it->array.end(), low);
+}
+
+size_t RoaringBitmap::GetSize() const {
+    return size_;
+}
+
+size_t RoaringBitmap::GetMemoryBytes() const {
+    size_t bytes = containers_.capacity() * sizeof(Container);
+    for (const Container& container : containers_) {
+        bytes += container.array.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+std::pmr::vector<RoaringBitmap::Container>::const_iterator RoaringBitmap::FindContainer(uint16_t key) const {
+    return std::lower_bound(containers_.begin(), containers_.end(), key,
+        [](const Container& container, uint16_t key) { return container.key < key; });
+}
+
+void RoaringBitmap::ConvertToBitmap(Container& container) {
+    container.bits.assign(BITMAP_WORD_COUNT, 0);
+    for (const uint16_t low : container.array) {
+        container.bits[low / 64] |= uint64_t{1} << (low % 64);
+    }
+    container.array.clear();
+    container.array.shrink_to_fit();
+}
+
+void RoaringBitmap::ConvertToArray(Container& container) {
+    container.array.reserve(container.cardinality);
+    for (size_t word_index = 0; word_index < BITMAP_WORD_COUNT; ++word_index) {
+        for (uint32_t bit = 0; bit < 64; ++bit) {
+            if ((container.bits[word_index] >> bit) & 1) {
+                container.array.push_back(static_cast<uint16_t>(word_index * 64 + bit));
+            }
+        }
+    }
+    container.bits.clear();
+    container.bits.shrink_to_fit();
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// сжатое множество 32-битных чисел по схеме Roaring Bitmap: числа группируются по старшим 16 битам,
+// а группа хранит младшие 16 бит отсортированным массивом (пока элементов не больше 4096)
+// либо битовой картой на 65536 бит; память берётся из заданного ресурса, как и у словарей индекса
+class RoaringBitmap {
+public:
+    explicit RoaringBitmap(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void Add(uint32_t value);
+
+    void Remove(uint32_t value);
+
+    bool Contains(uint32_t value) const;
+
+    size_t GetSize() const;
+
+    size_t GetMemoryBytes() const;
+
+    // обход элементов из отрезка [first, last] в порядке возрастания
+    template <typename Function>
+    void ForEachInRange(uint32_t first, uint32_t last, Function function) const;
+
+private:
+    struct Container {
+        explicit Container(std::pmr::memory_resource* resource)
+            : array(resource)
+            , bits(resource) {
+        }
+
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        std::pmr::vector<uint16_t> array;
+        std::pmr::vector<uint64_t> bits;
+
+        bool IsBitmap() const { return !bits.empty(); }
+    };
+
+    static const uint32_t ARRAY_MAX_SIZE = 4096;
+    static const size_t BITMAP_WORD_COUNT = 65536 / 64;
+
+    std::pmr::vector<Container>::const_iterator FindContainer(uint16_t key) const;
+
+    static void ConvertToBitmap(Container& container);
+
+    static void ConvertToArray(Container& container);
+
+    std::pmr::vector<Container> containers_;
+    size_t size_ = 0;
+};
+
+template <typename Function>
+void RoaringBitmap::ForEachInRange(uint32_t first, uint32_t last, Function function) const {
+    if (first > last) {
+        return;
+    }
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), static_cast<uint16_t>(first >> 16),
+        [](const Container& container, uint16_t key) { return container.key < key; });
+    for (; it != containers_.end() && it->key <= (last >> 16); ++it) {
+        const uint32_t high = static_cast<uint32_t>(it->key) << 16;
+        if (it->IsBitmap()) {
+            for (size_t word_index = 0; word_index < BITMAP_WORD_COUNT; ++word_index) {
+                const uint64_t word = it->bits[word_index];
+                if (word == 0) {
+                    continue;
+                }
+                for (uint32_t bit = 0; bit < 64; ++bit) {
+                    if (((word >> bit) & 1) == 0) {
+                        continue;
+                    }
+                    const uint32_t value = high | static_cast<uint32_t>(word_index * 64 + bit);
+                    if (value > last) {
+                        return;
+                    }
+                    if (value >= first) {
+                        function(value);
+                    }
+                }
+            }
+        } else {
+            for (const uint16_t low : it->array) {
+                const uint32_t value = high | low;
+                if (value > last) {
+                    return;
+                }
+                if (value >= first) {
+                    function(value);
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
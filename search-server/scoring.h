@@ -0,0 +1,74 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// статистика коллекции документов, от которой зависят формулы ранжирования
+struct CorpusStats {
+    size_t document_count = 0;
+    double average_document_length = 0.0;
+};
+
+// политики ранжирования подставляются в FindTopDocuments параметром шаблона, поэтому формула
+// встраивается в цикл по спискам документов без виртуальных вызовов. Политика обязана предоставить:
+//   USES_DOCUMENT_LENGTH - нужна ли формуле длина документа (иначе она не загружается в цикле);
+//   Prepare(corpus)      - подготовка к запросу по статистике коллекции;
+//   ComputeIdf(df)       - вес слова, встречающегося в df документах (один раз на слово запроса);
+//   Score(tf, idf, len)  - вклад слова в релевантность документа длины len с частотой слова tf
+
+// классическая мера TF-IDF
+class TfIdfScoring {
+public:
+    static constexpr bool USES_DOCUMENT_LENGTH = false;
+
+    void Prepare(const CorpusStats& corpus) {
+        document_count_ = corpus.document_count;
+    }
+
+    double ComputeIdf(size_t document_frequency) const {
+        return std::log(document_count_ * 1.0 / document_frequency);
+    }
+
+    double Score(double term_frequency, double idf, uint32_t /*document_length*/) const {
+        return term_frequency * idf;
+    }
+
+private:
+    size_t document_count_ = 0;
+};
+
+// мера Okapi BM25: насыщение частоты слова параметром k1 и нормировка на длину документа параметром b
+class Bm25Scoring {
+public:
+    static constexpr bool USES_DOCUMENT_LENGTH = true;
+
+    explicit Bm25Scoring(double k1 = 1.2, double b = 0.75)
+        : k1_(k1)
+        , b_(b) {
+    }
+
+    void Prepare(const CorpusStats& corpus) {
+        document_count_ = corpus.document_count;
+        // множитель длины документа в знаменателе: k1 * (1 - b + b * len / avgdl)
+        length_norm_base_ = k1_ * (1.0 - b_);
+        length_norm_factor_ = corpus.average_document_length > 0.0 ? k1_ * b_ / corpus.average_document_length : 0.0;
+    }
+
+    double ComputeIdf(size_t document_frequency) const {
+        return std::log((document_count_ - document_frequency + 0.5) / (document_frequency + 0.5) + 1.0);
+    }
+
+    double Score(double term_frequency, double idf, uint32_t document_length) const {
+        // в индексе хранится частота слова, нормированная на длину документа, - восстанавливаем число вхождений
+        const double term_count = term_frequency * document_length;
+        const double length_norm = length_norm_base_ + length_norm_factor_ * document_length;
+        return idf * term_count * (k1_ + 1.0) / (term_count + length_norm);
+    }
+
+private:
+    double k1_;
+    double b_;
+    size_t document_count_ = 0;
+    double length_norm_base_ = 0.0;
+    double length_norm_factor_ = 0.0;
+};
\ No newline at end of file
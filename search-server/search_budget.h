@@ -0,0 +1,23 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "document.h"
+
+// ограничение работы одного запроса; нулевое значение снимает соответствующее ограничение
+struct SearchBudget {
+    // время от начала выполнения запроса, включая его разбор
+    std::chrono::nanoseconds time_limit{ 0 };
+    // число проверенных записей списков документов
+    size_t max_postings = 0;
+};
+
+// выдача запроса с ограниченным бюджетом
+struct BudgetedSearchResult {
+    std::vector<Document> documents;
+    // бюджет исчерпан до обхода всех списков документов: выдача и релевантности могут отличаться
+    // от FindTopDocuments
+    bool is_approximate = false;
+    size_t postings_scanned = 0;
+};
\ No newline at end of file
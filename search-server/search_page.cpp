@@ -0,0 +1,44 @@
+#include "search_page.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+std::string EncodeSearchCursor(const SearchCursor& cursor) {
+    uint64_t relevance_bits = 0;
+    static_assert(sizeof(relevance_bits) == sizeof(cursor.relevance));
+    std::memcpy(&relevance_bits, &cursor.relevance, sizeof(relevance_bits));
+
+    char buffer[16];
+    char* buffer_end = std::to_chars(buffer, buffer + sizeof(buffer), relevance_bits, 16).ptr;
+    return std::string(buffer, buffer_end) + "."s + std::to_string(cursor.rating) + "."s + std::to_string(cursor.id);
+}
+
+// разбор числа до разделителя или конца строки с проверкой, что число занимает всю часть
+template <typename Number>
+static std::string_view ParseCursorPart(std::string_view text, Number& value, int base = 10) {
+    const auto separator = text.find('.');
+    const std::string_view part = text.substr(0, separator);
+    const auto [ptr, error] = std::from_chars(part.data(), part.data() + part.size(), value, base);
+    if (part.empty() || error != std::errc() || ptr != part.data() + part.size()) {
+        throw std::invalid_argument("Invalid search cursor"s);
+    }
+    return separator == text.npos ? std::string_view() : text.substr(separator + 1);
+}
+
+SearchCursor DecodeSearchCursor(std::string_view text) {
+    SearchCursor cursor;
+    uint64_t relevance_bits = 0;
+    std::string_view rest = ParseCursorPart(text, relevance_bits, 16);
+    rest = ParseCursorPart(rest, cursor.rating);
+    const bool has_id = !rest.empty();
+    rest = has_id ? ParseCursorPart(rest, cursor.id) : rest;
+    if (!has_id || !rest.empty() || text.back() == '.') {
+        throw std::invalid_argument("Invalid search cursor"s);
+    }
+    std::memcpy(&cursor.relevance, &relevance_bits, sizeof(relevance_bits));
+    return cursor;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+
+// позиция в выдаче: последний выданный документ, после которого начинается следующая страница
+struct SearchCursor {
+    double relevance = 0.0;
+    int rating = 0;
+    int id = 0;
+};
+
+// курсор кодируется непрозрачной строкой; релевантность сохраняется побитово,
+// чтобы сравнение с пересчитанной релевантностью было точным
+std::string EncodeSearchCursor(const SearchCursor& cursor);
+
+// некорректная строка приводит к исключению std::invalid_argument
+SearchCursor DecodeSearchCursor(std::string_view text);
+
+// страница выдачи
+struct SearchPage {
+    std::vector<Document> documents;
+    // курсор для запроса следующей страницы; пустой, если страниц больше нет
+    std::string next_cursor;
+};
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "search_server.h"
 
-SearchServer::SearchServer(std::string_view stop_words)
-    : SearchServer(SplitIntoWords(stop_words)) {}
+#include <charconv>
 
-SearchServer::SearchServer(const std::string& stop_words)
-    : SearchServer(SplitIntoWords(std::string_view(stop_words))) {}
+SearchServer::SearchServer(std::string_view stop_words, std::pmr::memory_resource* resource)
+    : SearchServer(SplitIntoWords(stop_words), resource) {}
+
+SearchServer::SearchServer(const std::string& stop_words, std::pmr::memory_resource* resource)
+    : SearchServer(SplitIntoWords(std::string_view(stop_words)), resource) {}
 
 void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
     if (document_id < 0) {
@@ -14,33 +16,179 @@ void SearchServer::AddDocument(int document_id, std::string_view document, Docum
     } else if (!IsValidWord(document)) {
         throw std::invalid_argument("Invalid characters in the text of the added document"s);
     }
+    METRICS_STAGE(MetricsStage::ADD_DOCUMENT);
+    METRICS_COUNT(MetricsCounter::DOCUMENTS_ADDED, 1);
     
+    // всё, что может выбросить исключение при разборе текста, выполняется до изменения индекса
     const auto words = SplitIntoWordsNoStop(document);
     const double TF = 1.0 / words.size();
+    const int rating = ComputeAverageRating(ratings);
+    std::vector<std::pair<std::string_view, uint32_t>> word_positions;
+    if (positional_index_) {
+        // стоп-слова не индексируются, но занимают позиции, как и в тексте фразы запроса
+        uint32_t position = 0;
+        for (std::string_view word : SplitIntoWords(document)) {
+            if (!IsStopWord(word)) {
+                word_positions.emplace_back(word, position);
+            }
+            ++position;
+        }
+    }
+    // массив длин лишь растёт, а хранилище текстов проверяет id само, поэтому они заполняются первыми:
+    // их исключения не затронут индекс
+    ReserveDenseDocumentLength(document_id);
+    if (document_store_) {
+        document_store_->Add(document_id, document);
+    }
+
     auto& word_freqs = document_to_word_freqs_[document_id];
     
     for (std::string_view word : words) {
-        word_to_document_freqs_[std::string(word)][document_id] += TF;
-        word_freqs[word_to_document_freqs_.find(std::string(word))->first] += TF;
+        // строка-ключ создаётся прямо в узле словаря, с памятью из ресурса индекса
+        auto word_it = word_to_document_freqs_.lower_bound(word);
+        if (word_it == word_to_document_freqs_.end() || word_it->first != word) {
+            word_it = word_to_document_freqs_.emplace_hint(word_it, std::piecewise_construct,
+                std::forward_as_tuple(word), std::forward_as_tuple());
+            AddTermTrigrams(*word_it);
+        }
+        word_it->second[document_id] += TF;
+        word_freqs[word_it->first] += TF;
+    }
+    documents_.emplace(document_id, Properties{ rating, status, static_cast<uint32_t>(words.size()) });
+    if (static_cast<size_t>(document_id) < dense_document_lengths_.size()) {
+        dense_document_lengths_[document_id] = static_cast<uint32_t>(words.size());
     }
-    documents_.emplace(document_id, Properties{ ComputeAverageRating(ratings), status });
+    for (const auto& [word, term_frequency] : word_freqs) {
+        auto& champions = word_to_champions_[word];
+        // длина списка документов нужна, только пока в списке лидеров есть место
+        const size_t posting_count = champions.size() < CHAMPION_LIST_SIZE ? word_to_document_freqs_.find(word)->second.size() : 0;
+        AddChampion(champions, posting_count, { term_frequency, rating, document_id });
+    }
+    status_to_document_ids_[static_cast<size_t>(status)].Add(document_id);
+    total_document_length_ += words.size();
     document_ids_.insert(document_id);
+    if (positional_index_) {
+        positional_index_->Add(document_id, word_positions);
+    }
+    ++index_version_;
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-    });
+    return FindTopDocuments(raw_query, DocumentFilter::ByStatus(status));
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const {
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(context, raw_query, DocumentFilter::ByStatus(status));
+}
+
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query) const {
+    return FindTopDocuments(context, raw_query, DocumentStatus::ACTUAL);
+}
+
+SearchServer::PreparedQuery SearchServer::PrepareQuery(std::string_view raw_query) const {
+    PreparedQuery query;
+    query.raw_query_ = std::string(raw_query);
+    query.server_ = this;
+    query.index_version_ = index_version_;
+    const auto parsed_query = ParseQuery(query.raw_query_);
+    const auto scorer = PrepareScoring(TfIdfScoring());
+    // слова разрешаются в записи словаря, их представления ссылаются на ключи словаря
+    const auto resolve = [&](std::string_view word) -> std::optional<ResolvedTerm> {
+        const auto word_it = word_to_document_freqs_.find(word);
+        if (word_it == word_to_document_freqs_.end()) {
+            return std::nullopt;
+        }
+        const auto& postings = word_it->second;
+        return ResolvedTerm{ word_it->first, &postings, &word_to_champions_.find(word)->second,
+                             postings.empty() ? 0.0 : scorer.ComputeIdf(postings.size()) };
+    };
+    for (std::string_view word : parsed_query.plus_words) {
+        if (auto term = resolve(word)) {
+            query.plus_terms_.push_back(*term);
+        }
+    }
+    for (std::string_view word : parsed_query.minus_words) {
+        if (auto term = resolve(word)) {
+            query.minus_terms_.push_back(*term);
+        }
+    }
+    for (std::string_view word : parsed_query.required_words) {
+        if (auto term = resolve(word)) {
+            query.required_terms_.push_back(*term);
+        } else {
+            query.has_missing_required_term_ = true;
+        }
+    }
+    // слова фраз обязательны, поэтому при найденных обязательных словах все они есть в словаре
+    if (!query.has_missing_required_term_) {
+        for (const PhraseWord& phrase_word : parsed_query.phrase_words) {
+            query.phrase_words_.push_back({ word_to_document_freqs_.find(phrase_word.word)->first, phrase_word.offset });
+        }
+        query.phrases_ = parsed_query.phrases;
+    }
+    return query;
+}
+
+void SearchServer::RevalidatePreparedQuery(PreparedQuery& query) const {
+    if (query.server_ != this || query.index_version_ != index_version_) {
+        query = PrepareQuery(query.raw_query_);
+    }
+}
+
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, PreparedQuery& query, DocumentStatus status) const {
+    return FindTopDocuments(context, query, DocumentFilter::ByStatus(status));
+}
+
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, PreparedQuery& query) const {
+    return FindTopDocuments(context, query, DocumentStatus::ACTUAL);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(PreparedQuery& query, DocumentStatus status) const {
+    return FindTopDocuments(query, DocumentFilter::ByStatus(status));
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(PreparedQuery& query) const {
+    return FindTopDocuments(query, DocumentStatus::ACTUAL);
+}
+
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const std::vector<std::string>& raw_queries) const {
+    return FindTopDocumentsBatch(raw_queries, DocumentFilter::ByStatus(DocumentStatus::ACTUAL));
+}
+
+SearchPage SearchServer::FindDocumentsPage(std::string_view raw_query, size_t offset, size_t limit) const {
+    return FindDocumentsPage(raw_query, offset, limit, DocumentFilter::ByStatus(DocumentStatus::ACTUAL));
+}
+
+SearchPage SearchServer::FindDocumentsPageAfter(std::string_view raw_query, std::string_view cursor, size_t limit) const {
+    return FindDocumentsPageAfter(raw_query, cursor, limit, DocumentFilter::ByStatus(DocumentStatus::ACTUAL));
+}
+
+BudgetedSearchResult SearchServer::FindTopDocumentsWithinBudget(std::string_view raw_query, const SearchBudget& budget,
+                                                                DocumentStatus status) const {
+    return FindTopDocumentsWithinBudget(raw_query, budget, DocumentFilter::ByStatus(status));
+}
+
+BudgetedSearchResult SearchServer::FindTopDocumentsWithinBudget(std::string_view raw_query, const SearchBudget& budget) const {
+    return FindTopDocumentsWithinBudget(raw_query, budget, DocumentStatus::ACTUAL);
+}
+
+QueryExplanation SearchServer::ExplainTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return ExplainTopDocuments(raw_query, DocumentFilter::ByStatus(status));
+}
+
+QueryExplanation SearchServer::ExplainTopDocuments(std::string_view raw_query) const {
+    return ExplainTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
 matching_result SearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
     if (!document_ids_.count(document_id)) {
         throw std::out_of_range("Requested id "s + std::to_string(document_id) + " is incorrect or doesn't exist"s);
     }
+    METRICS_STAGE(MetricsStage::MATCH_DOCUMENT);
     
     const auto query = ParseQuery(raw_query);
     
@@ -50,7 +198,17 @@ matching_result SearchServer::MatchDocument(std::string_view raw_query, int docu
             auto it = word_to_document_freqs_.find(word);
             return it != word_to_document_freqs_.end() && it->second.count(document_id);
         })) {
-        return { {}, documents_.at(document_id).status };
+        return { std::vector<std::string_view>{}, documents_.at(document_id).status };
+    }
+    // документ без хотя бы одного обязательного слова запросу не соответствует
+    if (!std::all_of(
+        query.required_words.begin(), query.required_words.end(),
+        [&](std::string_view word) {
+            auto it = word_to_document_freqs_.find(word);
+            return it != word_to_document_freqs_.end() && it->second.count(document_id);
+        })
+        || !MatchesPhrases(query.phrase_words, query.phrases, document_id)) {
+        return { std::vector<std::string_view>{}, documents_.at(document_id).status };
     }
     
     std::vector<std::string_view> matched_words(query.plus_words.size());
@@ -67,30 +225,245 @@ matching_result SearchServer::MatchDocument(std::string_view raw_query, int docu
     return { matched_words, documents_.at(document_id).status };
 }
 
+matching_result SearchServer::MatchDocument(PreparedQuery& query, int document_id) const {
+    if (!document_ids_.count(document_id)) {
+        throw std::out_of_range("Requested id "s + std::to_string(document_id) + " is incorrect or doesn't exist"s);
+    }
+    METRICS_STAGE(MetricsStage::MATCH_DOCUMENT);
+    RevalidatePreparedQuery(query);
+    const auto contains_document = [document_id](const ResolvedTerm& term) {
+        return term.postings->count(document_id) > 0;
+    };
+    const auto status = documents_.at(document_id).status;
+    if (query.has_missing_required_term_
+        || std::any_of(query.minus_terms_.begin(), query.minus_terms_.end(), contains_document)
+        || !std::all_of(query.required_terms_.begin(), query.required_terms_.end(), contains_document)
+        || !MatchesPhrases(query.phrase_words_, query.phrases_, document_id)) {
+        return { std::vector<std::string_view>{}, status };
+    }
+    std::vector<std::string_view> matched_words;
+    for (const ResolvedTerm& term : query.plus_terms_) {
+        if (contains_document(term)) {
+            matched_words.push_back(term.word);
+        }
+    }
+    return { matched_words, status };
+}
+
 void SearchServer::RemoveDocument(int document_id) {
+    METRICS_STAGE(MetricsStage::REMOVE_DOCUMENT);
+    METRICS_COUNT(MetricsCounter::DOCUMENTS_REMOVED, 1);
     if (auto it = document_to_word_freqs_.find(document_id); it != document_to_word_freqs_.end()) {
+        if (positional_index_) {
+            std::vector<std::string_view> words;
+            for (const auto& [word, freq] : it->second) {
+                words.push_back(word);
+            }
+            positional_index_->Remove(document_id, words);
+        }
         document_to_word_freqs_.erase(it);
     }
     for (auto& word_to_id_freq : word_to_document_freqs_) {
         if (auto it = word_to_id_freq.second.find(document_id); it != word_to_id_freq.second.end()) {
             word_to_id_freq.second.erase(it);
+            RemoveChampion(word_to_id_freq.first, word_to_id_freq.second, document_id);
         }
     }
     auto it_to_erase = documents_.find(document_id);
+    status_to_document_ids_[static_cast<size_t>(it_to_erase->second.status)].Remove(document_id);
+    total_document_length_ -= it_to_erase->second.length;
     documents_.erase(it_to_erase);
     document_ids_.erase(document_id);
+    if (document_store_) {
+        document_store_->Remove(document_id);
+    }
+    ++index_version_;
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
+const std::pmr::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
     if (!document_to_word_freqs_.at(document_id).empty()) {
         return document_to_word_freqs_.at(document_id);
     }
-    static const std::map<std::string_view, double> no_result_found;
+    static const std::pmr::map<std::string_view, double> no_result_found;
     return no_result_found;
 }
 
 int SearchServer::GetDocumentCount() const { return documents_.size(); }
 
+void SearchServer::SetTypoTolerance(bool enabled) {
+    typo_tolerance_ = enabled;
+    ++index_version_;
+}
+
+void SearchServer::EnableDocumentStore(size_t block_size, size_t cache_block_count) {
+    if (!documents_.empty()) {
+        throw std::logic_error("Document store must be enabled before adding documents"s);
+    }
+    document_store_.emplace(block_size, cache_block_count);
+}
+
+void SearchServer::EnablePositionalIndex() {
+    if (!documents_.empty()) {
+        throw std::logic_error("Positional index must be enabled before adding documents"s);
+    }
+    positional_index_.emplace();
+}
+
+std::string SearchServer::GetDocumentText(int document_id) const {
+    if (!document_store_) {
+        throw std::logic_error("Document store is disabled"s);
+    }
+    return document_store_->GetText(document_id);
+}
+
+std::vector<std::string> SearchServer::GetSnippets(std::string_view raw_query, int document_id, const SnippetOptions& options) const {
+    if (!document_store_) {
+        throw std::logic_error("Document store is disabled"s);
+    }
+    const auto [words, status] = MatchDocument(raw_query, document_id);
+    return document_store_->GetSnippets(document_id, words, options);
+}
+
+// новый документ попадает в список, если он выше последней записи или если в списке есть место
+// и в нём уже все остальные документы слова; иначе граница для документов вне списка нарушилась бы
+void SearchServer::AddChampion(std::pmr::vector<Champion>& champions, size_t posting_count, const Champion& champion) {
+    if (!champions.empty() && !CompareChampions(champion, champions.back())
+        && (champions.size() == CHAMPION_LIST_SIZE || champions.size() + 1 < posting_count)) {
+        return;
+    }
+    if (champions.size() == CHAMPION_LIST_SIZE) {
+        champions.pop_back();
+    }
+    champions.insert(std::upper_bound(champions.begin(), champions.end(), champion, CompareChampions), champion);
+}
+
+// после удаления записи оставшиеся по-прежнему лидируют среди документов слова, список лишь короче
+void SearchServer::RemoveChampion(std::string_view word, const std::pmr::map<int, double>& document_freqs, int document_id) {
+    auto& champions = word_to_champions_.find(word)->second;
+    const auto it = std::find_if(champions.begin(), champions.end(),
+        [document_id](const Champion& champion) { return champion.document_id == document_id; });
+    if (it == champions.end()) {
+        return;
+    }
+    champions.erase(it);
+    if (champions.size() < CHAMPION_LIST_SIZE / 2 && champions.size() < document_freqs.size()) {
+        RebuildChampions(champions, document_freqs);
+    }
+}
+
+// отбор лучших записей через кучу в самом векторе списка; неполный список когда-то был полным
+// (иначе в нём были бы все документы слова), поэтому ёмкости хватает и память не выделяется
+void SearchServer::RebuildChampions(std::pmr::vector<Champion>& champions, const std::pmr::map<int, double>& document_freqs) const {
+    champions.clear();
+    for (const auto [document_id, term_frequency] : document_freqs) {
+        const Champion champion{ term_frequency, documents_.at(document_id).rating, document_id };
+        if (champions.size() < CHAMPION_LIST_SIZE) {
+            champions.push_back(champion);
+            std::push_heap(champions.begin(), champions.end(), CompareChampions);
+        } else if (CompareChampions(champion, champions.front())) {
+            std::pop_heap(champions.begin(), champions.end(), CompareChampions);
+            champions.back() = champion;
+            std::push_heap(champions.begin(), champions.end(), CompareChampions);
+        }
+    }
+    std::sort_heap(champions.begin(), champions.end(), CompareChampions);
+}
+
+bool SearchServer::CompareChampions(const Champion& lhs, const Champion& rhs) {
+    return std::tie(rhs.term_frequency, rhs.rating, lhs.document_id) < std::tie(lhs.term_frequency, lhs.rating, rhs.document_id);
+}
+
+// оценка памяти узла красно-чёрного дерева: цвет (с выравниванием) и три указателя плюс значение
+template <typename Container>
+static size_t TreeNodesBytes(const Container& container) {
+    return container.size() * (4 * sizeof(void*) + sizeof(typename Container::value_type));
+}
+
+// память строки вне объекта (без учёта оптимизации коротких строк)
+template <typename String>
+static size_t StringHeapBytes(const String& str) {
+    const char* object_begin = reinterpret_cast<const char*>(&str);
+    const bool is_local = str.data() >= object_begin && str.data() < object_begin + sizeof(str);
+    return is_local ? 0 : str.capacity() + 1;
+}
+
+void SearchServer::ReserveDenseDocumentLength(int document_id) {
+    const size_t size = dense_document_lengths_.size();
+    const size_t limit = 2 * (documents_.size() + 1) + MIN_DENSE_LENGTHS;
+    const size_t id = static_cast<size_t>(document_id);
+    if (id < size || id >= limit) {
+        return;
+    }
+    // удвоение размера, как у вектора, но не дальше предела: массив остаётся плотным
+    dense_document_lengths_.resize(std::min(limit, std::max(id + 1, 2 * size)));
+    for (auto it = documents_.lower_bound(static_cast<int>(size));
+         it != documents_.end() && static_cast<size_t>(it->first) < dense_document_lengths_.size(); ++it) {
+        dense_document_lengths_[it->first] = it->second.length;
+    }
+}
+
+IndexStats SearchServer::GetIndexStats() const {
+    IndexStats stats;
+    stats.term_count = word_to_document_freqs_.size();
+    stats.term_dictionary_bytes = TreeNodesBytes(word_to_document_freqs_);
+    for (const auto& [word, document_freqs] : word_to_document_freqs_) {
+        const size_t posting_list_length = document_freqs.size();
+        stats.total_postings += posting_list_length;
+        stats.max_posting_list_length = std::max(stats.max_posting_list_length, posting_list_length);
+        stats.term_dictionary_bytes += StringHeapBytes(word);
+        stats.postings_bytes += TreeNodesBytes(document_freqs);
+
+        size_t bucket = 0;
+        while ((posting_list_length >> (bucket + 1)) != 0) {
+            ++bucket;
+        }
+        if (stats.posting_list_length_histogram.size() <= bucket) {
+            stats.posting_list_length_histogram.resize(bucket + 1);
+        }
+        ++stats.posting_list_length_histogram[bucket];
+    }
+    if (stats.term_count != 0) {
+        stats.average_posting_list_length = stats.total_postings * 1.0 / stats.term_count;
+    }
+
+    stats.champion_lists_bytes = TreeNodesBytes(word_to_champions_);
+    for (const auto& [word, champions] : word_to_champions_) {
+        stats.champion_lists_bytes += champions.capacity() * sizeof(Champion);
+    }
+
+    // узел хеш-таблицы - указатель на следующий узел, значение и сохранённый хеш
+    stats.trigram_index_bytes = trigram_terms_.capacity() * sizeof(void*)
+        + trigram_to_term_ids_.bucket_count() * sizeof(void*)
+        + trigram_to_term_ids_.size() * (2 * sizeof(void*) + sizeof(decltype(trigram_to_term_ids_)::value_type));
+    for (const auto& [trigram_key, term_ids] : trigram_to_term_ids_) {
+        stats.trigram_index_bytes += term_ids.capacity() * sizeof(uint32_t);
+    }
+
+    stats.forward_index_bytes = TreeNodesBytes(document_to_word_freqs_);
+    for (const auto& [document_id, word_freqs] : document_to_word_freqs_) {
+        stats.forward_index_bytes += TreeNodesBytes(word_freqs);
+    }
+
+    stats.document_table_bytes = TreeNodesBytes(documents_) + TreeNodesBytes(document_ids_)
+        + dense_document_lengths_.capacity() * sizeof(uint32_t);
+    if (positional_index_) {
+        stats.positional_index_bytes = positional_index_->GetMemoryBytes();
+    }
+    if (document_store_) {
+        stats.document_store_bytes = document_store_->GetMemoryBytes();
+        stats.document_text_bytes = document_store_->GetTextBytes();
+    }
+    for (const RoaringBitmap& document_ids : status_to_document_ids_) {
+        stats.document_table_bytes += document_ids.GetMemoryBytes();
+    }
+
+    stats.stop_words_bytes = TreeNodesBytes(stop_words_);
+    for (const auto& stop_word : stop_words_) {
+        stats.stop_words_bytes += StringHeapBytes(stop_word);
+    }
+    return stats;
+}
+
 std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
     std::vector<std::string_view> words;
     for (std::string_view word : SplitIntoWords(text)) {
@@ -108,33 +481,325 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view word) cons
     if (word.empty()) { throw std::invalid_argument("The search server received an empty search request"s); }
     
     bool is_minus = false;
+    bool is_required = false;
     if (word[0] == '-') {
         is_minus = true;
         word.remove_prefix(1);
+    } else if (word[0] == '+') {
+        is_required = true;
+        word.remove_prefix(1);
     }
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
+    if (word.empty() || word[0] == '-' || word[0] == '+' || !IsValidWord(word)) {
         throw std::invalid_argument("Invalid query word: "s + std::string(word));
     }
-    return { word, is_minus, IsStopWord(word) };
+    const bool is_wildcard = word.find('*') != word.npos;
+    // шаблон без префикса раскрывался бы перебором всего словаря,
+    // а обязательность шаблона неоднозначна (все слова или хотя бы одно)
+    if (is_wildcard && (word[0] == '*' || is_required)) {
+        throw std::invalid_argument("Invalid wildcard query word: "s + std::string(word));
+    }
+    return { word, is_minus, !is_wildcard && IsStopWord(word), is_required, is_wildcard };
+}
+
+void SearchServer::ExpandWildcard(std::string_view pattern, std::vector<std::string_view>& words) const {
+    const std::string_view prefix = pattern.substr(0, pattern.find('*'));
+    const std::string_view suffix_pattern = pattern.substr(prefix.size());
+    size_t expansion_count = 0;
+    for (auto it = word_to_document_freqs_.lower_bound(prefix);
+         it != word_to_document_freqs_.end() && std::string_view(it->first).substr(0, prefix.size()) == prefix; ++it) {
+        const std::string_view word = it->first;
+        if (it->second.empty() || !MatchesWildcard(suffix_pattern, word.substr(prefix.size()))) {
+            continue;
+        }
+        if (++expansion_count > MAX_WILDCARD_EXPANSION) {
+            throw std::invalid_argument("Wildcard "s + std::string(pattern) + " matches more than "s
+                                        + std::to_string(MAX_WILDCARD_EXPANSION) + " words"s);
+        }
+        words.push_back(word);
+    }
 }
 
 SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool removing_doubles) const {
-    Query query;
-    for (std::string_view word : SplitIntoWords(text)) {
+    QueryContext context;
+    ParseQuery(text, context, removing_doubles);
+    return { std::move(context.plus_words), std::move(context.minus_words), std::move(context.required_words),
+             std::move(context.phrase_words), std::move(context.phrases) };
+}
+
+void SearchServer::ParseQuery(std::string_view text, QueryContext& context, bool removing_doubles) const {
+    METRICS_STAGE(MetricsStage::PARSE_QUERY);
+    auto& minus_words = context.minus_words;
+    auto& plus_words = context.plus_words;
+    auto& required_words = context.required_words;
+    auto& phrase_words = context.phrase_words;
+    auto& phrases = context.phrases;
+    minus_words.clear();
+    plus_words.clear();
+    required_words.clear();
+    phrase_words.clear();
+    phrases.clear();
+    SplitIntoWords(text, context.words);
+    // открытая фраза: её первое слово в phrase_words и номер следующего слова во фразе
+    bool is_in_phrase = false;
+    uint32_t phrase_begin = 0;
+    uint32_t phrase_offset = 0;
+    for (std::string_view word : context.words) {
+        // слова фразы не исправляются и не раскрываются; все они обязательны
+        if (is_in_phrase || word[0] == '"') {
+            if (!is_in_phrase) {
+                word.remove_prefix(1);
+                is_in_phrase = true;
+                phrase_begin = phrase_words.size();
+                phrase_offset = 0;
+            }
+            uint32_t slop = 0;
+            const size_t quote_pos = word.find('"');
+            if (quote_pos != word.npos) {
+                slop = ParsePhraseSlop(word.substr(quote_pos + 1));
+                word = word.substr(0, quote_pos);
+                is_in_phrase = false;
+            }
+            if (!word.empty()) {
+                if (word[0] == '-' || word[0] == '+' || word.find('*') != word.npos || !IsValidWord(word)) {
+                    throw std::invalid_argument("Invalid phrase query word: "s + std::string(word));
+                }
+                if (!IsStopWord(word)) {
+                    phrase_words.push_back({ word, phrase_offset });
+                    plus_words.push_back(word);
+                    required_words.push_back(word);
+                }
+                ++phrase_offset;
+            }
+            // фраза из одного слова (без стоп-слов) - просто обязательное слово
+            if (!is_in_phrase) {
+                if (phrase_words.size() - phrase_begin >= 2) {
+                    phrases.push_back({ phrase_begin, static_cast<uint32_t>(phrase_words.size()), slop });
+                } else {
+                    phrase_words.resize(phrase_begin);
+                }
+            }
+            continue;
+        }
+        if (word.size() > 1 && (word[0] == '-' || word[0] == '+') && word[1] == '"') {
+            throw std::invalid_argument("Phrases cannot be excluded or marked as required: "s + std::string(word));
+        }
         const auto query_word = ParseQueryWord(word);
+        if (query_word.is_wildcard) {
+            ExpandWildcard(query_word.word, query_word.is_minus ? minus_words : plus_words);
+            continue;
+        }
+        if (typo_tolerance_ && !query_word.is_stop && !query_word.is_minus && !query_word.is_required) {
+            const auto word_it = word_to_document_freqs_.find(query_word.word);
+            if ((word_it == word_to_document_freqs_.end() || word_it->second.empty())
+                && CorrectTypo(query_word.word, context)) {
+                continue;
+            }
+        }
+        // обязательное стоп-слово не сужает выдачу, как и обычное
         if (!query_word.is_stop) {
             query_word.is_minus
-                ? query.minus_words.push_back(query_word.word)
-                : query.plus_words.push_back(query_word.word);
+                ? minus_words.push_back(query_word.word)
+                : plus_words.push_back(query_word.word);
+            if (query_word.is_required) {
+                required_words.push_back(query_word.word);
+            }
         }
     }
     if (removing_doubles) {
-        std::sort(query.minus_words.begin(), query.minus_words.end());
-        query.minus_words.resize(std::unique(query.minus_words.begin(), query.minus_words.end()) - query.minus_words.begin());
-        std::sort(query.plus_words.begin(), query.plus_words.end());
-        query.plus_words.resize(std::unique(query.plus_words.begin(), query.plus_words.end()) - query.plus_words.begin());
+        std::sort(minus_words.begin(), minus_words.end());
+        minus_words.resize(std::unique(minus_words.begin(), minus_words.end()) - minus_words.begin());
+        std::sort(plus_words.begin(), plus_words.end());
+        plus_words.resize(std::unique(plus_words.begin(), plus_words.end()) - plus_words.begin());
+        std::sort(required_words.begin(), required_words.end());
+        required_words.resize(std::unique(required_words.begin(), required_words.end()) - required_words.begin());
     }
-    return query;
+    if (is_in_phrase) {
+        throw std::invalid_argument("Unterminated phrase in query: "s + std::string(text));
+    }
+    if (!phrases.empty() && !positional_index_) {
+        throw std::logic_error("Phrase queries require the positional index"s);
+    }
+}
+
+uint32_t SearchServer::ParsePhraseSlop(std::string_view suffix) {
+    if (suffix.empty()) {
+        return 0;
+    }
+    uint32_t slop = 0;
+    if (suffix[0] == '~') {
+        const auto [ptr, error] = std::from_chars(suffix.data() + 1, suffix.data() + suffix.size(), slop);
+        if (error == std::errc() && ptr == suffix.data() + suffix.size() && suffix.size() > 1 && slop <= MAX_PHRASE_SLOP) {
+            return slop;
+        }
+    }
+    throw std::invalid_argument("Invalid phrase suffix: "s + std::string(suffix));
+}
+
+bool SearchServer::FindPhraseTerms(const std::vector<PhraseWord>& phrase_words,
+                                   std::vector<const PositionalIndex::TermPositions*>& phrase_terms) const {
+    phrase_terms.clear();
+    for (const PhraseWord& phrase_word : phrase_words) {
+        const auto* term = positional_index_->Find(phrase_word.word);
+        if (!term) {
+            return false;
+        }
+        phrase_terms.push_back(term);
+    }
+    return true;
+}
+
+bool SearchServer::MatchesPhrases(const std::vector<PhraseWord>& phrase_words, const std::vector<QueryPhrase>& phrases,
+                                  const std::vector<const PositionalIndex::TermPositions*>& phrase_terms, int document_id,
+                                  std::vector<std::vector<uint32_t>>& phrase_positions) {
+    if (phrase_positions.size() < phrase_words.size()) {
+        phrase_positions.resize(phrase_words.size());
+    }
+    for (size_t i = 0; i < phrase_words.size(); ++i) {
+        if (!phrase_terms[i]->Decode(document_id, phrase_positions[i])) {
+            return false;
+        }
+    }
+    return std::all_of(phrases.begin(), phrases.end(), [&](const QueryPhrase& phrase) {
+        return PositionalIndex::MatchPhrase(phrase_positions, phrase_words, phrase);
+    });
+}
+
+bool SearchServer::MatchesPhrases(const std::vector<PhraseWord>& phrase_words, const std::vector<QueryPhrase>& phrases,
+                                  int document_id) const {
+    if (phrases.empty()) {
+        return true;
+    }
+    std::vector<const PositionalIndex::TermPositions*> phrase_terms;
+    std::vector<std::vector<uint32_t>> phrase_positions;
+    return FindPhraseTerms(phrase_words, phrase_terms)
+        && MatchesPhrases(phrase_words, phrases, phrase_terms, document_id, phrase_positions);
+}
+
+// при k правках совпадают все триграммы слова, кроме не более чем 3k, поэтому проверяются
+// расстоянием Левенштейна только слова допустимой длины с достаточным числом общих триграмм
+bool SearchServer::CorrectTypo(std::string_view word, QueryContext& context) const {
+    const size_t max_distance = word.size() < 3 ? 0 : word.size() < 6 ? 1 : MAX_TYPO_DISTANCE;
+    if (max_distance == 0 || word.size() > MAX_EDIT_DISTANCE_PATTERN_LENGTH) {
+        return false;
+    }
+    std::array<uint32_t, MAX_EDIT_DISTANCE_PATTERN_LENGTH + 3> trigrams;
+    const size_t trigram_count = CollectTrigrams(word, trigrams);
+    if (trigram_count <= 3 * max_distance) {
+        return false;
+    }
+    auto& candidates = context.term_candidates;
+    candidates.clear();
+    for (size_t length = word.size() - max_distance; length <= word.size() + max_distance; ++length) {
+        for (size_t i = 0; i < trigram_count; ++i) {
+            const auto it = trigram_to_term_ids_.find(trigrams[i] << 8 | static_cast<uint32_t>(length));
+            if (it != trigram_to_term_ids_.end()) {
+                candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // номера лучших кандидатов записываются в начало того же буфера
+    const size_t min_shared_trigrams = trigram_count - 3 * max_distance;
+    size_t best_distance = max_distance;
+    size_t accepted_count = 0;
+    for (size_t begin = 0, end = 0; begin < candidates.size(); begin = end) {
+        while (end < candidates.size() && candidates[end] == candidates[begin]) {
+            ++end;
+        }
+        const auto* term = trigram_terms_[candidates[begin]];
+        if (end - begin < min_shared_trigrams || term->second.empty()) {
+            continue;
+        }
+        const size_t distance = ComputeEditDistance(word, term->first);
+        if (distance > best_distance) {
+            continue;
+        }
+        if (distance < best_distance) {
+            best_distance = distance;
+            accepted_count = 0;
+        }
+        candidates[accepted_count++] = candidates[begin];
+    }
+    candidates.resize(accepted_count);
+    // из равноудалённых слов остаются встречающиеся в наибольшем числе документов
+    if (candidates.size() > MAX_TYPO_CORRECTIONS) {
+        std::partial_sort(candidates.begin(), candidates.begin() + MAX_TYPO_CORRECTIONS, candidates.end(),
+            [this](uint32_t lhs, uint32_t rhs) { return trigram_terms_[lhs]->second.size() > trigram_terms_[rhs]->second.size(); });
+        candidates.resize(MAX_TYPO_CORRECTIONS);
+    }
+    for (uint32_t term_id : candidates) {
+        context.plus_words.push_back(trigram_terms_[term_id]->first);
+    }
+    return !candidates.empty();
+}
+
+// слова длиннее любого исправляемого слова запроса с допустимым расстоянием в индекс не заносятся
+void SearchServer::AddTermTrigrams(const std::pair<const std::pmr::string, std::pmr::map<int, double>>& term) {
+    if (term.first.size() > MAX_EDIT_DISTANCE_PATTERN_LENGTH + MAX_TYPO_DISTANCE) {
+        return;
+    }
+    const uint32_t term_id = static_cast<uint32_t>(trigram_terms_.size());
+    trigram_terms_.push_back(&term);
+    std::array<uint32_t, MAX_EDIT_DISTANCE_PATTERN_LENGTH + 3> trigrams;
+    const size_t trigram_count = CollectTrigrams(term.first, trigrams);
+    for (size_t i = 0; i < trigram_count; ++i) {
+        trigram_to_term_ids_[trigrams[i] << 8 | static_cast<uint32_t>(term.first.size())].push_back(term_id);
+    }
+}
+
+// символы 1 и 2 не встречаются в допустимых словах и служат маркерами начала и конца
+size_t SearchServer::CollectTrigrams(std::string_view word, std::array<uint32_t, MAX_EDIT_DISTANCE_PATTERN_LENGTH + 3>& trigrams) {
+    const auto padded_char = [word](size_t i) -> uint32_t {
+        if (i < 2) {
+            return 1;
+        }
+        return i - 2 < word.size() ? static_cast<unsigned char>(word[i - 2]) : 2;
+    };
+    const size_t trigram_count = word.size() + 1;
+    for (size_t i = 0; i < trigram_count; ++i) {
+        trigrams[i] = padded_char(i) << 16 | padded_char(i + 1) << 8 | padded_char(i + 2);
+    }
+    std::sort(trigrams.begin(), trigrams.begin() + trigram_count);
+    return std::unique(trigrams.begin(), trigrams.begin() + trigram_count) - trigrams.begin();
+}
+
+bool SearchServer::MatchesFilterAttributes(int document_id, const DocumentFilter& filter) const {
+    if (filter.id_parity != DocumentFilter::IdParity::ANY
+        && (document_id % 2 == 0) != (filter.id_parity == DocumentFilter::IdParity::EVEN)) {
+        return false;
+    }
+    if (filter.min_rating || filter.max_rating) {
+        const int rating = documents_.at(document_id).rating;
+        return (!filter.min_rating || rating >= *filter.min_rating)
+            && (!filter.max_rating || rating <= *filter.max_rating);
+    }
+    return true;
+}
+
+const std::pmr::map<int, double>* SearchServer::FindPostings(std::string_view word) const {
+    const auto word_it = word_to_document_freqs_.find(word);
+    return word_it != word_to_document_freqs_.end() ? &word_it->second : nullptr;
+}
+
+const std::pmr::map<int, double>* SearchServer::FindPostings(const ResolvedTerm& term) const {
+    return term.postings;
+}
+
+const std::pmr::vector<SearchServer::Champion>& SearchServer::FindChampions(std::string_view word) const {
+    return word_to_champions_.find(word)->second;
+}
+
+const std::pmr::vector<SearchServer::Champion>& SearchServer::FindChampions(const ResolvedTerm& term) const {
+    return *term.champions;
+}
+
+std::string_view SearchServer::GetTermWord(std::string_view word) {
+    return word;
+}
+
+std::string_view SearchServer::GetTermWord(const ResolvedTerm& term) {
+    return term.word;
 }
 
 bool SearchServer::IsStopWord(std::string_view word) const {
@@ -150,6 +815,57 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     return std::accumulate(ratings.begin(), ratings.end(), 0) / static_cast<int>(ratings.size());
 }
 
-double SearchServer::GetIDF(std::string_view word) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.find(word)->second.size());
+bool SearchServer::CompareDocuments(const Document& lhs, const Document& rhs) {
+    return lhs.relevance > rhs.relevance ||
+        ((std::abs(lhs.relevance - rhs.relevance) < EPSILON) && lhs.rating > rhs.rating);
+}
+
+void SearchServer::CoalesceRelevance(std::vector<std::pair<int, double>>& document_to_relevance) {
+    std::sort(document_to_relevance.begin(), document_to_relevance.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+    if (document_to_relevance.empty()) {
+        return;
+    }
+    auto last = document_to_relevance.begin();
+    for (auto it = std::next(last); it != document_to_relevance.end(); ++it) {
+        if (it->first == last->first) {
+            last->second += it->second;
+        } else {
+            *(++last) = *it;
+        }
+    }
+    document_to_relevance.erase(std::next(last), document_to_relevance.end());
+}
+
+void SearchServer::SelectTopDocuments(std::vector<Document>& documents) {
+    METRICS_STAGE(MetricsStage::TOP_K);
+    const size_t result_count = std::min(documents.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+    std::partial_sort(documents.begin(), documents.begin() + result_count, documents.end(), CompareDocuments);
+    documents.resize(result_count);
+}
+
+SearchPage SearchServer::SelectPage(std::vector<Document>& documents, size_t offset, size_t limit) {
+    METRICS_STAGE(MetricsStage::TOP_K);
+    SearchPage page;
+    const size_t first = std::min(offset, documents.size());
+    const size_t last = first + std::min(limit, documents.size() - first);
+    std::partial_sort(documents.begin(), documents.begin() + last, documents.end(), ComparePagedDocuments);
+    page.documents.assign(documents.begin() + first, documents.begin() + last);
+    if (last > first && last < documents.size()) {
+        const Document& last_document = page.documents.back();
+        page.next_cursor = EncodeSearchCursor({ last_document.relevance, last_document.rating, last_document.id });
+    }
+    return page;
+}
+
+bool SearchServer::ComparePagedDocuments(const Document& lhs, const Document& rhs) {
+    // релевантность сравнивается точно: сравнение с допуском EPSILON нетранзитивно, и страницы
+    // по курсору могли бы повторять или пропускать документы
+    if (lhs.relevance != rhs.relevance) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
 }
\ No newline at end of file
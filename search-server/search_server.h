@@ -1,19 +1,36 @@
 #pragma once
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <execution>
 #include <functional>
+#include <limits>
 #include <map>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
 #include <set>
 #include <stdexcept>
 #include <string>
 #include <thread>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 #include "concurrent_map.h"
 #include "document.h"
+#include "document_store.h"
+#include "document_filter.h"
+#include "index_stats.h"
+#include "metrics.h"
+#include "positional_index.h"
+#include "query_context.h"
+#include "query_explanation.h"
+#include "roaring_bitmap.h"
+#include "scoring.h"
+#include "search_budget.h"
+#include "search_page.h"
 #include "string_processing.h"
 
 using namespace std::string_literals;
@@ -24,15 +41,30 @@ const double EPSILON = 1e-6;
 
 class SearchServer {
 public:
+    // все контейнеры индекса выделяют память из переданного ресурса (по умолчанию - из кучи);
+    // ресурс должен пережить сервер, при использовании monotonic_buffer_resource
+    // уничтожение индекса сводится к единовременному освобождению арены.
+    // Несинхронизированные ресурсы (unsynchronized_pool_resource, monotonic_buffer_resource) допустимы,
+    // только пока индекс изменяется из одного потока: параллельная версия RemoveDocument освобождает
+    // узлы из нескольких потоков лишь в куче, а с любым другим ресурсом удаляет слова последовательно.
+    // Если сервер изменяется из нескольких потоков или ресурс используется ещё где-то параллельно
+    // с par-перегрузками, ресурс должен быть синхронизированным (synchronized_pool_resource)
+
     // конструктор, принимающий стоп-слова в виде контейнера строк
     template <typename StringContainer>
-    explicit SearchServer(const StringContainer& stop_words);
+    explicit SearchServer(const StringContainer& stop_words,
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     // конструкторы, принимающие стоп-слова единой строкой
-    explicit SearchServer(std::string_view stop_words);
-    explicit SearchServer(const std::string& stop_words);
+    explicit SearchServer(std::string_view stop_words,
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    explicit SearchServer(const std::string& stop_words,
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    // во всех версиях FindTopDocuments вместо предиката можно передать DocumentFilter:
+    // его условия проверяются по битовым картам статусов до вычисления релевантности
+
     // версии FindTopDocuments без политик распараллеливания
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
@@ -51,9 +83,122 @@ public:
     template<typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&&, std::string_view raw_query) const;
 
+    // версии FindTopDocuments с переиспользуемым контекстом запроса:
+    // результат хранится в контексте и остаётся действительным до следующего запроса с этим контекстом
+    template <typename DocumentPredicate>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentStatus status) const;
+
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query) const;
+
+    // версии FindTopDocuments с выбором функции ранжирования (TfIdfScoring, Bm25Scoring, см. scoring.h);
+    // остальные версии ранжируют по TF-IDF
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+                                           const ScoringPolicy& scoring) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate, typename ScoringPolicy,
+              typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&&, std::string_view raw_query, DocumentPredicate document_predicate,
+                                           const ScoringPolicy& scoring) const;
+
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate,
+                                                  const ScoringPolicy& scoring) const;
+
+    // выполнение запроса с разбором: слова запроса с длинами списков документов и IDF,
+    // число проверенных и отвергнутых предикатом записей, исключённых минус-словами документов
+    // и время каждого этапа; выдача совпадает с FindTopDocuments с теми же аргументами
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    QueryExplanation ExplainTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+                                         const ScoringPolicy& scoring) const;
+
+    template <typename DocumentPredicate>
+    QueryExplanation ExplainTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    QueryExplanation ExplainTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+
+    QueryExplanation ExplainTopDocuments(std::string_view raw_query) const;
+
+    // пакетное выполнение запросов: список документов каждого различного слова пакета обходится
+    // один раз (параллельно по словам) в плоский массив вкладов, который читают все запросы с этим словом;
+    // суммирование вкладов, исключение минус-слов и отбор топ-5 выполняются параллельно по запросам.
+    // Результат совпадает с FindTopDocuments для каждого запроса
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string>& raw_queries,
+                                                             DocumentPredicate document_predicate,
+                                                             const ScoringPolicy& scoring) const;
+
+    template <typename DocumentPredicate>
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string>& raw_queries,
+                                                             DocumentPredicate document_predicate) const;
+
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string>& raw_queries) const;
+
+    // постраничная выдача без ограничения топ-5: страница из limit документов, следующих за первыми offset,
+    // либо за документом, закодированным в курсоре (пустой курсор - первая страница).
+    // Упорядочивается только префикс выдачи до конца страницы, а не весь набор найденных документов;
+    // при равных релевантности и рейтинге документы следуют по возрастанию id
+    template <typename DocumentPredicate>
+    SearchPage FindDocumentsPage(std::string_view raw_query, size_t offset, size_t limit,
+                                 DocumentPredicate document_predicate) const;
+
+    SearchPage FindDocumentsPage(std::string_view raw_query, size_t offset, size_t limit) const;
+
+    template <typename DocumentPredicate>
+    SearchPage FindDocumentsPageAfter(std::string_view raw_query, std::string_view cursor, size_t limit,
+                                      DocumentPredicate document_predicate) const;
+
+    SearchPage FindDocumentsPageAfter(std::string_view raw_query, std::string_view cursor, size_t limit) const;
+
+    // выполнение запроса в пределах бюджета времени или числа проверенных записей: слова обходятся
+    // по убыванию IDF, чтобы самые избирательные списки были пройдены первыми, а по исчерпании
+    // бюджета выдаётся топ-5 по уже накопленной релевантности с признаком приблизительности
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    BudgetedSearchResult FindTopDocumentsWithinBudget(std::string_view raw_query, const SearchBudget& budget,
+                                                      DocumentPredicate document_predicate, const ScoringPolicy& scoring) const;
+
+    template <typename DocumentPredicate>
+    BudgetedSearchResult FindTopDocumentsWithinBudget(std::string_view raw_query, const SearchBudget& budget,
+                                                      DocumentPredicate document_predicate) const;
+
+    BudgetedSearchResult FindTopDocumentsWithinBudget(std::string_view raw_query, const SearchBudget& budget,
+                                                      DocumentStatus status) const;
+
+    BudgetedSearchResult FindTopDocumentsWithinBudget(std::string_view raw_query, const SearchBudget& budget) const;
+
+    // подготовленные запросы: разбор, проверка слов, стоп-слова, исправление опечаток и поиск слов в словаре
+    // выполняются один раз в PrepareQuery, а повторные выполнения обходятся без них.
+    // Если индекс изменился после подготовки, запрос перед выполнением подготавливается заново
+    class PreparedQuery;
+
+    PreparedQuery PrepareQuery(std::string_view raw_query) const;
+
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, PreparedQuery& query, DocumentPredicate document_predicate,
+                                                  const ScoringPolicy& scoring) const;
+
+    template <typename DocumentPredicate>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, PreparedQuery& query, DocumentPredicate document_predicate) const;
+
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, PreparedQuery& query, DocumentStatus status) const;
+
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, PreparedQuery& query) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(PreparedQuery& query, DocumentPredicate document_predicate) const;
+
+    std::vector<Document> FindTopDocuments(PreparedQuery& query, DocumentStatus status) const;
+
+    std::vector<Document> FindTopDocuments(PreparedQuery& query) const;
+
     // матчинг документов
     matching_result MatchDocument(std::string_view raw_query, int document_id) const;
 
+    // найденные слова - представления слов словаря, действительные, пока существует сервер
+    matching_result MatchDocument(PreparedQuery& query, int document_id) const;
+
     template<typename ExecutionPolicy>
     matching_result MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const;
     
@@ -64,64 +209,330 @@ public:
     void RemoveDocument(ExecutionPolicy&& policy, int document_id);
     
     // геттеры
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    const std::pmr::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
     
     int GetDocumentCount() const;
 
+    // статистика словаря, списков документов и оценка занимаемой индексом памяти
+    IndexStats GetIndexStats() const;
+
+    // исправление опечаток (включено по умолчанию): необязательное плюс-слово запроса, которого нет в словаре,
+    // заменяется ближайшими словами словаря на расстоянии Левенштейна до 1 (слова из 3-5 символов)
+    // или до 2 (из 6 и более символов); кандидаты отбираются по общим триграммам
+    void SetTypoTolerance(bool enabled);
+
+    // хранилище исходных текстов документов для фрагментов выдачи (выключено по умолчанию);
+    // включается до добавления первого документа, иначе выбрасывается logic_error
+    void EnableDocumentStore(size_t block_size = DocumentStore::DEFAULT_BLOCK_SIZE,
+                             size_t cache_block_count = DocumentStore::DEFAULT_CACHE_BLOCK_COUNT);
+
+    std::string GetDocumentText(int document_id) const;
+
+    // фрагменты текста документа с выделенными словами, которыми он соответствует запросу (по MatchDocument)
+    std::vector<std::string> GetSnippets(std::string_view raw_query, int document_id, const SnippetOptions& options = {}) const;
+
+    // позиционный индекс для фразовых запросов (выключен по умолчанию): "слово слово" находит документы
+    // с точной фразой, "слово слово"~N - со словами фразы в том же порядке и не больше чем N лишними словами
+    // между ними. Включается до добавления первого документа, иначе выбрасывается logic_error;
+    // запрос с фразой при выключенном индексе также выбрасывает logic_error
+    void EnablePositionalIndex();
+
     auto begin() const { return document_ids_.begin(); }
 
     auto end() const { return document_ids_.end(); }
     
 private:
+    // снимок индекса с квантованными вкладами строится по внутренним контейнерам сервера
+    friend class ImpactIndex;
+
     struct Properties {
         int rating;
         DocumentStatus status;
+        // длина документа в словах (без стоп-слов)
+        uint32_t length;
     };
     
     struct QueryWord {
         std::string_view word;
         bool is_minus;
         bool is_stop;
+        bool is_required;
+        // слово с '*' - шаблон, раскрываемый по словарю
+        bool is_wildcard;
     };
     
     struct Query {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
+        // обязательные слова входят и в plus_words
+        std::vector<std::string_view> required_words;
+        std::vector<PhraseWord> phrase_words;
+        std::vector<QueryPhrase> phrases;
+    };
+
+    // число записей списков документов, проверенных предикатом или фильтром, и прошедших проверку
+    struct PostingScanCounts {
+        size_t scanned = 0;
+        size_t accepted = 0;
+    };
+
+    // запись списка лидеров слова; список упорядочен по убыванию TF, при равной TF - по убыванию рейтинга,
+    // и любой документ слова вне списка не выше его последней записи
+    struct Champion {
+        double term_frequency;
+        int rating;
+        int document_id;
     };
     
     // поиск всех документов, соответствующих поисковому запросу и предикату
-    template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate,
+                                           const ScoringPolicy& scoring) const;
 
-    template<typename ExecutionPolicy, typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(ExecutionPolicy&&, const Query& query, DocumentPredicate document_predicate) const;
+    template<typename ExecutionPolicy, typename DocumentPredicate, typename ScoringPolicy>
+    std::vector<Document> FindAllDocuments(ExecutionPolicy&&, const Query& query, DocumentPredicate document_predicate,
+                                           const ScoringPolicy& scoring) const;
+
+    // слово подготовленного запроса, разрешённое в записи словаря
+    struct ResolvedTerm {
+        std::string_view word;
+        const std::pmr::map<int, double>* postings;
+        const std::pmr::vector<Champion>* champions;
+        // IDF по TF-IDF на момент подготовки: при изменении индекса запрос подготавливается заново
+        double tf_idf;
+    };
+
+    // доступ к списку документов, списку лидеров и IDF слова запроса: слово (std::string_view) ищется
+    // в словаре, у разрешённого слова (ResolvedTerm) всё найдено заранее; у слова вне словаря списка нет (nullptr)
+    const std::pmr::map<int, double>* FindPostings(std::string_view word) const;
+
+    const std::pmr::map<int, double>* FindPostings(const ResolvedTerm& term) const;
+
+    const std::pmr::vector<Champion>& FindChampions(std::string_view word) const;
+
+    const std::pmr::vector<Champion>& FindChampions(const ResolvedTerm& term) const;
+
+    static std::string_view GetTermWord(std::string_view word);
+
+    static std::string_view GetTermWord(const ResolvedTerm& term);
+
+    template <typename ScoringPolicy, typename Term>
+    static double ComputeTermIdf(const ScoringPolicy& scorer, const Term& term, size_t posting_count);
+
+    // позиции слов фраз в позиционном индексе; false, если какого-то слова фразы в нём нет
+    bool FindPhraseTerms(const std::vector<PhraseWord>& phrase_words,
+                         std::vector<const PositionalIndex::TermPositions*>& phrase_terms) const;
+
+    // есть ли в документе-кандидате все фразы запроса; позиции разбираются только для него
+    static bool MatchesPhrases(const std::vector<PhraseWord>& phrase_words, const std::vector<QueryPhrase>& phrases,
+                               const std::vector<const PositionalIndex::TermPositions*>& phrase_terms, int document_id,
+                               std::vector<std::vector<uint32_t>>& phrase_positions);
+
+    // то же с поиском позиций слов фраз, для проверки одного документа
+    bool MatchesPhrases(const std::vector<PhraseWord>& phrase_words, const std::vector<QueryPhrase>& phrases,
+                        int document_id) const;
+
+    // суффикс закрывающей кавычки фразы: пустой или ~N
+    static uint32_t ParsePhraseSlop(std::string_view suffix);
+
+    // при изменении индекса после подготовки (или подготовке другим сервером) запрос подготавливается заново
+    void RevalidatePreparedQuery(PreparedQuery& query) const;
+
+    // при переданном explanation заполняются сведения о словах, счётчики и время этапов
+    template <typename DocumentPredicate, typename ScoringPolicy>
+    void FindAllDocuments(QueryContext& context, DocumentPredicate document_predicate, const ScoringPolicy& scoring,
+                          QueryExplanation* explanation = nullptr) const;
+
+    // то же по явным спискам плюс-, минус- и обязательных слов (Term - std::string_view или ResolvedTerm)
+    template <typename Term, typename DocumentPredicate, typename ScoringPolicy>
+    void FindAllDocuments(QueryContext& context, const std::vector<Term>& plus_terms, const std::vector<Term>& minus_terms,
+                          const std::vector<Term>& required_terms, DocumentPredicate document_predicate,
+                          const ScoringPolicy& scoring, QueryExplanation* explanation = nullptr) const;
+
+    // документы, содержащие все обязательные слова и фразы запроса и прошедшие предикат, в порядке возрастания id
+    // с релевантностью по всем плюс-словам; списки документов пересекаются начиная с самого короткого
+    template <typename Term, typename DocumentPredicate, typename ScoringPolicy>
+    PostingScanCounts FindConjunctiveDocuments(QueryContext& context, const std::vector<Term>& plus_terms,
+                                               const std::vector<Term>& required_terms,
+                                               DocumentPredicate& document_predicate, const ScoringPolicy& scorer) const;
+
+    // ответ на запрос из одного-двух плюс-слов по их спискам лидеров: релевантность точно вычисляется
+    // только для документов из списков, а для остальных оценивается сверху по последним записям списков.
+    // Возвращает false, если выдачу нельзя гарантировать (или все списки документов слов короче
+    // списков лидеров и дешевле обойти их целиком) - тогда запрос выполняется полным обходом
+    template <typename Term, typename DocumentPredicate, typename ScoringPolicy>
+    bool FindTopDocumentsByChampions(const std::vector<Term>& plus_terms,
+                                     const std::vector<Term>& minus_terms,
+                                     DocumentPredicate& document_predicate, const ScoringPolicy& scoring,
+                                     std::vector<int>& candidate_ids, std::vector<Document>& matched_documents) const;
+
+    // поддержка списков лидеров при добавлении и удалении документа; список, сократившийся
+    // после удалений вдвое, заново набирается из списка документов слова
+    static void AddChampion(std::pmr::vector<Champion>& champions, size_t posting_count, const Champion& champion);
+
+    void RemoveChampion(std::string_view word, const std::pmr::map<int, double>& document_freqs, int document_id);
+
+    void RebuildChampions(std::pmr::vector<Champion>& champions, const std::pmr::map<int, double>& document_freqs) const;
+
+    static bool CompareChampions(const Champion& lhs, const Champion& rhs);
+
+    // упорядочивание вкладов слов {id, вклад} по id и суммирование вкладов каждого документа
+    static void CoalesceRelevance(std::vector<std::pair<int, double>>& document_to_relevance);
+
+    // упорядочивание найденных документов и отсечение топ-5
+    static void SelectTopDocuments(std::vector<Document>& documents);
+
+    // упорядочивание первых offset + limit документов и выдача последних limit из них
+    static SearchPage SelectPage(std::vector<Document>& documents, size_t offset, size_t limit);
+
+    // копия политики ранжирования, подготовленная по текущей статистике коллекции
+    template <typename ScoringPolicy>
+    ScoringPolicy PrepareScoring(const ScoringPolicy& scoring) const;
+
+    // длина документа в словах (без стоп-слов); нужна только политикам, учитывающим длину
+    template <typename ScoringPolicy>
+    uint32_t GetDocumentLength(int document_id) const;
+
+    // расширяет массив длин до id добавляемого документа, если id не слишком велик,
+    // и переносит в новую часть массива длины уже добавленных документов
+    void ReserveDenseDocumentLength(int document_id);
+
+    // обход записей {id документа, TF} списка документов слова, прошедших предикат или фильтр
+    template <typename DocumentPredicate, typename Callback>
+    PostingScanCounts ForEachMatchingPosting(const std::pmr::map<int, double>& document_freqs,
+                                DocumentPredicate& document_predicate, Callback callback) const;
+
+    // возвращает число проверенных записей
+    template <typename Callback>
+    size_t ForEachFilteredPosting(const std::pmr::map<int, double>& document_freqs,
+                                const DocumentFilter& filter, Callback callback) const;
+
+    bool MatchesFilterAttributes(int document_id, const DocumentFilter& filter) const;
     
     std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
     
     QueryWord ParseQueryWord(std::string_view text) const;
+
+    // добавление в words слов словаря с непустыми списками документов, подходящих под шаблон;
+    // перебираются только слова с буквальным префиксом шаблона (до первой '*')
+    void ExpandWildcard(std::string_view pattern, std::vector<std::string_view>& words) const;
+
+    // добавление в context.plus_words ближайших к word слов словаря; false, если таких нет
+    bool CorrectTypo(std::string_view word, QueryContext& context) const;
+
+    // занесение нового слова словаря в индекс триграмм
+    void AddTermTrigrams(const std::pair<const std::pmr::string, std::pmr::map<int, double>>& term);
+
+    // различные триграммы слова, дополненного двумя символами начала и одним символом конца; возвращает их число
+    static size_t CollectTrigrams(std::string_view word, std::array<uint32_t, MAX_EDIT_DISTANCE_PATTERN_LENGTH + 3>& trigrams);
     
     Query ParseQuery(std::string_view text, bool removing_doubles = true) const;
 
+    void ParseQuery(std::string_view text, QueryContext& context, bool removing_doubles = true) const;
+
     bool IsStopWord(std::string_view word) const;
 
     static bool IsValidWord(std::string_view word);
     
     static int ComputeAverageRating(const std::vector<int>& ratings);
+
+    // порядок выдачи: по убыванию релевантности, при равной релевантности - по убыванию рейтинга
+    static bool CompareDocuments(const Document& lhs, const Document& rhs);
+
+    // строгий порядок постраничной выдачи: по убыванию точной релевантности, затем по убыванию рейтинга
+    // и по возрастанию id; от CompareDocuments отличается только для релевантностей в пределах EPSILON
+    static bool ComparePagedDocuments(const Document& lhs, const Document& rhs);
     
-    double GetIDF(std::string_view word) const;
+    static const size_t DOCUMENT_STATUS_COUNT = 4;
+    // перебор битовой карты статуса с поиском в дереве вместо обхода списка документов
+    // выгоден, только если карта во столько раз короче списка
+    static const size_t BITMAP_SCAN_RATIO = 8;
+    // длина списка лидеров слова и наибольшее число плюс-слов запроса, выполняемого по спискам лидеров
+    static const size_t CHAMPION_LIST_SIZE = 32;
+    static const size_t MAX_CHAMPION_QUERY_WORDS = 2;
+    // наибольшее число слов, в которое раскрывается шаблон запроса
+    static const size_t MAX_WILDCARD_EXPANSION = 128;
+    // размер массива длин документов, до которого он растёт независимо от числа документов
+    static const size_t MIN_DENSE_LENGTHS = 1024;
+    // наибольшее число лишних слов во вхождении фразы с ~N
+    static const uint32_t MAX_PHRASE_SLOP = 64;
+    // наибольшее расстояние исправления опечатки и число слов, которыми заменяется одно слово запроса
+    static const size_t MAX_TYPO_DISTANCE = 2;
+    static const size_t MAX_TYPO_CORRECTIONS = 4;
+    // период опроса часов при обходе списков документов с бюджетом времени
+    static const size_t BUDGET_CLOCK_CHECK_INTERVAL = 64;
 
-    std::map<std::string, std::map<int, double>, std::less<>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
-    std::set<std::string, std::less<>> stop_words_;
-    std::map<int, Properties> documents_;
-    std::set<int> document_ids_;
+    std::pmr::map<std::pmr::string, std::pmr::map<int, double>, std::less<>> word_to_document_freqs_;
+    std::pmr::map<int, std::pmr::map<std::string_view, double>> document_to_word_freqs_;
+    // списки лидеров слов; ключи ссылаются на строки словаря word_to_document_freqs_
+    std::pmr::map<std::string_view, std::pmr::vector<Champion>, std::less<>> word_to_champions_;
+    // индекс триграмм для исправления опечаток: слова словаря в порядке появления и номера слов
+    // по ключу {триграмма, длина слова}, чтобы кандидаты сразу отбирались и по длине
+    std::pmr::vector<const std::pair<const std::pmr::string, std::pmr::map<int, double>>*> trigram_terms_;
+    std::pmr::unordered_map<uint32_t, std::pmr::vector<uint32_t>> trigram_to_term_ids_;
+    bool typo_tolerance_ = true;
+    // растёт при каждом изменении индекса и настроек разбора запросов; по ней проверяются подготовленные запросы
+    uint64_t index_version_ = 0;
+    std::pmr::set<std::pmr::string, std::less<>> stop_words_;
+    std::pmr::map<int, Properties> documents_;
+    std::pmr::set<int> document_ids_;
+    // битовые карты id документов для каждого статуса
+    std::array<RoaringBitmap, DOCUMENT_STATUS_COUNT> status_to_document_ids_;
+    // длины документов по id для BM25 без поиска в дереве на каждую запись списка документов;
+    // массив растёт, только пока id не больше чем вдвое превышают число документов, длины документов
+    // с большими id берутся из documents_
+    std::pmr::vector<uint32_t> dense_document_lengths_;
+    // сумма длин документов для средней длины
+    uint64_t total_document_length_ = 0;
+    std::optional<DocumentStore> document_store_;
+    std::optional<PositionalIndex> positional_index_;
 };
 
+// запрос, разобранный один раз для многократного выполнения: слова разрешены в списки документов
+// и списки лидеров словаря, для плюс-слов сохранён IDF. Запрос помнит подготовивший его сервер и версию индекса;
+// выполнение может подготовить его заново, поэтому потоки выполняют собственные копии
+class SearchServer::PreparedQuery {
+public:
+    const std::string& GetRawQuery() const {
+        return raw_query_;
+    }
+
+private:
+    friend class SearchServer;
+
+    std::string raw_query_;
+    const SearchServer* server_ = nullptr;
+    uint64_t index_version_ = 0;
+    // слова вне словаря отброшены; обязательные слова входят и в plus_terms_
+    std::vector<ResolvedTerm> plus_terms_;
+    std::vector<ResolvedTerm> minus_terms_;
+    std::vector<ResolvedTerm> required_terms_;
+    // слова фраз - представления слов словаря
+    std::vector<PhraseWord> phrase_words_;
+    std::vector<QueryPhrase> phrases_;
+    // обязательного слова нет в словаре: запросу не соответствует ни один документ
+    bool has_missing_required_term_ = false;
+};
+
+using PreparedQuery = SearchServer::PreparedQuery;
+
 // шаблонный конструктор
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words)
-    : stop_words_(SplitIntoStrings(stop_words))
+SearchServer::SearchServer(const StringContainer& stop_words, std::pmr::memory_resource* resource)
+    : word_to_document_freqs_(resource)
+    , document_to_word_freqs_(resource)
+    , word_to_champions_(resource)
+    , trigram_terms_(resource)
+    , trigram_to_term_ids_(resource)
+    , stop_words_(resource)
+    , documents_(resource)
+    , document_ids_(resource)
+    , status_to_document_ids_{ RoaringBitmap(resource), RoaringBitmap(resource), RoaringBitmap(resource), RoaringBitmap(resource) }
+    , dense_document_lengths_(resource)
 {
+    for (const auto& stop_word : SplitIntoStrings(stop_words)) {
+        stop_words_.emplace(stop_word);
+    }
     if (!std::all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
         throw std::invalid_argument("Some of stop words are invalid"s);
     }
@@ -134,25 +545,35 @@ std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
 
 template<typename ExecutionPolicy, typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(policy, raw_query, document_predicate, TfIdfScoring());
+}
+
+template<typename ExecutionPolicy, typename DocumentPredicate, typename ScoringPolicy, typename>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+                                                     const ScoringPolicy& scoring) const {
+    METRICS_COUNT(MetricsCounter::QUERIES, 1);
     const auto query = ParseQuery(raw_query);
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
+    std::vector<Document> matched_documents;
+    std::vector<int> candidate_ids;
+    if (!query.required_words.empty()
+        || !FindTopDocumentsByChampions(query.plus_words, query.minus_words, document_predicate, scoring,
+                                        candidate_ids, matched_documents)) {
+        matched_documents = FindAllDocuments(policy, query, document_predicate, scoring);
 
-    std::sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-        return lhs.relevance > rhs.relevance ||
-            ((std::abs(lhs.relevance - rhs.relevance) < EPSILON) && lhs.rating > rhs.rating);
-        });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        METRICS_STAGE(MetricsStage::TOP_K);
+        std::sort(matched_documents.begin(), matched_documents.end(), CompareDocuments);
+        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        }
     }
+    METRICS_COUNT(MetricsCounter::EMPTY_RESULTS, matched_documents.empty() ? 1 : 0);
 
     return matched_documents;
 }
 
 template<typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-    });
+    return FindTopDocuments(policy, raw_query, DocumentFilter::ByStatus(status));
 }
 
 template<typename ExecutionPolicy>
@@ -160,27 +581,362 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, s
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
-// шаблонный метод FindAllDocuments с передачей пользовательского предиката
+template <typename DocumentPredicate, typename ScoringPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+                                                     const ScoringPolicy& scoring) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, scoring);
+}
+
+// шаблонный метод FindTopDocuments с переиспользуемым контекстом запроса
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(context, raw_query, document_predicate, TfIdfScoring());
 }
 
-template<typename ExecutionPolicy, typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(std::thread::hardware_concurrency());
-    auto plus_words_processing = [&](std::string_view word) {
-        if (word_to_document_freqs_.count(word)) {
-            const double IDF = GetIDF(word);
-            for (const auto [document_id, TF] : word_to_document_freqs_.find(word)->second) {
+template <typename DocumentPredicate, typename ScoringPolicy>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate,
+                                                            const ScoringPolicy& scoring) const {
+    METRICS_COUNT(MetricsCounter::QUERIES, 1);
+    ParseQuery(raw_query, context);
+    auto& matched_documents = context.documents;
+    if (!context.required_words.empty()
+        || !FindTopDocumentsByChampions(context.plus_words, context.minus_words, document_predicate, scoring,
+                                        context.candidate_ids, matched_documents)) {
+        FindAllDocuments(context, document_predicate, scoring);
+        SelectTopDocuments(matched_documents);
+    }
+    METRICS_COUNT(MetricsCounter::EMPTY_RESULTS, matched_documents.empty() ? 1 : 0);
+
+    return matched_documents;
+}
+
+// шаблонные методы FindTopDocuments с подготовленным запросом: тот же путь, что и по тексту запроса,
+// но без разбора и поиска слов в словаре
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(PreparedQuery& query, DocumentPredicate document_predicate) const {
+    QueryContext context;
+    FindTopDocuments(context, query, document_predicate);
+    return std::move(context.documents);
+}
+
+template <typename DocumentPredicate>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, PreparedQuery& query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(context, query, document_predicate, TfIdfScoring());
+}
+
+template <typename DocumentPredicate, typename ScoringPolicy>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, PreparedQuery& query, DocumentPredicate document_predicate,
+                                                            const ScoringPolicy& scoring) const {
+    METRICS_COUNT(MetricsCounter::QUERIES, 1);
+    RevalidatePreparedQuery(query);
+    auto& matched_documents = context.documents;
+    if (query.has_missing_required_term_) {
+        matched_documents.clear();
+    } else if (!query.required_terms_.empty()
+        || !FindTopDocumentsByChampions(query.plus_terms_, query.minus_terms_, document_predicate, scoring,
+                                        context.candidate_ids, matched_documents)) {
+        context.phrase_words = query.phrase_words_;
+        context.phrases = query.phrases_;
+        FindAllDocuments(context, query.plus_terms_, query.minus_terms_, query.required_terms_, document_predicate, scoring);
+        SelectTopDocuments(matched_documents);
+    }
+    METRICS_COUNT(MetricsCounter::EMPTY_RESULTS, matched_documents.empty() ? 1 : 0);
+
+    return matched_documents;
+}
+
+template <typename ScoringPolicy, typename Term>
+double SearchServer::ComputeTermIdf(const ScoringPolicy& scorer, const Term& term, size_t posting_count) {
+    if constexpr (std::is_same_v<Term, ResolvedTerm> && std::is_same_v<ScoringPolicy, TfIdfScoring>) {
+        return term.tf_idf;
+    } else {
+        return scorer.ComputeIdf(posting_count);
+    }
+}
+
+// шаблонный метод ExplainTopDocuments
+template <typename DocumentPredicate>
+QueryExplanation SearchServer::ExplainTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return ExplainTopDocuments(raw_query, document_predicate, TfIdfScoring());
+}
+
+// запрос выполняется тем же путём, что и FindTopDocuments с контекстом,
+// но с временным контекстом, чтобы разбор не влиял на буферы вызывающего
+template <typename DocumentPredicate, typename ScoringPolicy>
+QueryExplanation SearchServer::ExplainTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+                                                   const ScoringPolicy& scoring) const {
+    using Clock = std::chrono::steady_clock;
+    METRICS_COUNT(MetricsCounter::QUERIES, 1);
+    QueryExplanation explanation;
+    QueryContext context;
+
+    auto phase_start = Clock::now();
+    ParseQuery(raw_query, context);
+    explanation.parse_duration = Clock::now() - phase_start;
+
+    FindAllDocuments(context, document_predicate, scoring, &explanation);
+
+    phase_start = Clock::now();
+    SelectTopDocuments(context.documents);
+    explanation.top_k_duration = Clock::now() - phase_start;
+    METRICS_COUNT(MetricsCounter::EMPTY_RESULTS, context.documents.empty() ? 1 : 0);
+
+    explanation.documents = std::move(context.documents);
+    return explanation;
+}
+
+// шаблонные методы пакетного выполнения запросов
+template <typename DocumentPredicate>
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const std::vector<std::string>& raw_queries,
+                                                                       DocumentPredicate document_predicate) const {
+    return FindTopDocumentsBatch(raw_queries, document_predicate, TfIdfScoring());
+}
+
+template <typename DocumentPredicate, typename ScoringPolicy>
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const std::vector<std::string>& raw_queries,
+                                                                       DocumentPredicate document_predicate,
+                                                                       const ScoringPolicy& scoring) const {
+    METRICS_COUNT(MetricsCounter::QUERIES, raw_queries.size());
+    const auto scorer = PrepareScoring(scoring);
+    std::vector<Query> queries;
+    queries.reserve(raw_queries.size());
+    // различные плюс-слова пакета; запросы с обязательными словами выполняются
+    // по отдельности через пересечение списков и в группировке не участвуют
+    std::vector<std::string_view> words;
+    for (const std::string& raw_query : raw_queries) {
+        queries.push_back(ParseQuery(raw_query));
+        if (queries.back().required_words.empty()) {
+            words.insert(words.end(), queries.back().plus_words.begin(), queries.back().plus_words.end());
+        }
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    // вклады {id, вклад} записей списка документов каждого слова: список обходится один раз,
+    // а плоский массив вкладов затем читают все запросы с этим словом
+    std::vector<std::vector<std::pair<int, double>>> word_contributions(words.size());
+    std::vector<size_t> word_indexes(words.size());
+    std::iota(word_indexes.begin(), word_indexes.end(), 0);
+    {
+        METRICS_STAGE(MetricsStage::POSTING_TRAVERSAL);
+        std::for_each(std::execution::par, word_indexes.begin(), word_indexes.end(), [&](size_t i) {
+            const auto word_it = word_to_document_freqs_.find(words[i]);
+            if (word_it == word_to_document_freqs_.end()) {
+                return;
+            }
+            auto& contributions = word_contributions[i];
+            contributions.reserve(word_it->second.size());
+            const double IDF = scorer.ComputeIdf(word_it->second.size());
+            ForEachMatchingPosting(word_it->second, document_predicate, [&](int document_id, double TF) {
+                contributions.emplace_back(document_id, scorer.Score(TF, IDF, GetDocumentLength<ScoringPolicy>(document_id)));
+            });
+        });
+    }
+
+    std::vector<size_t> query_indexes(queries.size());
+    std::iota(query_indexes.begin(), query_indexes.end(), 0);
+    std::vector<std::vector<Document>> results(queries.size());
+    std::for_each(std::execution::par, query_indexes.begin(), query_indexes.end(), [&](size_t i) {
+        const Query& query = queries[i];
+        std::vector<Document>& matched_documents = results[i];
+        if (!query.required_words.empty()) {
+            matched_documents = FindAllDocuments(std::execution::seq, query, document_predicate, scoring);
+        } else {
+            std::vector<std::pair<int, double>> document_to_relevance;
+            for (std::string_view word : query.plus_words) {
+                const auto& contributions = word_contributions[std::lower_bound(words.begin(), words.end(), word) - words.begin()];
+                document_to_relevance.insert(document_to_relevance.end(), contributions.begin(), contributions.end());
+            }
+            CoalesceRelevance(document_to_relevance);
+            std::vector<int> excluded_document_ids;
+            for (std::string_view word : query.minus_words) {
+                if (const auto word_it = word_to_document_freqs_.find(word); word_it != word_to_document_freqs_.end()) {
+                    for (const auto [document_id, freq] : word_it->second) {
+                        excluded_document_ids.push_back(document_id);
+                    }
+                }
+            }
+            std::sort(excluded_document_ids.begin(), excluded_document_ids.end());
+            for (const auto& [document_id, relevance] : document_to_relevance) {
+                if (!std::binary_search(excluded_document_ids.begin(), excluded_document_ids.end(), document_id)) {
+                    matched_documents.emplace_back(document_id, relevance, documents_.at(document_id).rating);
+                }
+            }
+        }
+        SelectTopDocuments(matched_documents);
+        METRICS_COUNT(MetricsCounter::EMPTY_RESULTS, matched_documents.empty() ? 1 : 0);
+    });
+    return results;
+}
+
+// шаблонные методы постраничной выдачи
+template <typename DocumentPredicate>
+SearchPage SearchServer::FindDocumentsPage(std::string_view raw_query, size_t offset, size_t limit,
+                                           DocumentPredicate document_predicate) const {
+    METRICS_COUNT(MetricsCounter::QUERIES, 1);
+    QueryContext context;
+    ParseQuery(raw_query, context);
+    FindAllDocuments(context, document_predicate, TfIdfScoring());
+    return SelectPage(context.documents, offset, limit);
+}
+
+template <typename DocumentPredicate>
+SearchPage SearchServer::FindDocumentsPageAfter(std::string_view raw_query, std::string_view cursor, size_t limit,
+                                                DocumentPredicate document_predicate) const {
+    if (cursor.empty()) {
+        return FindDocumentsPage(raw_query, 0, limit, document_predicate);
+    }
+    const SearchCursor last_seen = DecodeSearchCursor(cursor);
+    const Document last_document(last_seen.id, last_seen.relevance, last_seen.rating);
+
+    METRICS_COUNT(MetricsCounter::QUERIES, 1);
+    QueryContext context;
+    ParseQuery(raw_query, context);
+    FindAllDocuments(context, document_predicate, TfIdfScoring());
+    // документы до курсора включительно уже выданы
+    auto& documents = context.documents;
+    documents.erase(std::remove_if(documents.begin(), documents.end(),
+        [&last_document](const Document& document) { return !ComparePagedDocuments(last_document, document); }),
+        documents.end());
+    return SelectPage(documents, 0, limit);
+}
+
+// шаблонные методы выполнения запроса с бюджетом
+template <typename DocumentPredicate>
+BudgetedSearchResult SearchServer::FindTopDocumentsWithinBudget(std::string_view raw_query, const SearchBudget& budget,
+                                                                DocumentPredicate document_predicate) const {
+    return FindTopDocumentsWithinBudget(raw_query, budget, document_predicate, TfIdfScoring());
+}
+
+// релевантность накапливается по словам, как в FindAllDocuments с контекстом; обязательные
+// и минус-слова проверяются поиском в их списках только для набравших релевантность документов,
+// поэтому их списки не обходятся и бюджет на них не расходуется
+template <typename DocumentPredicate, typename ScoringPolicy>
+BudgetedSearchResult SearchServer::FindTopDocumentsWithinBudget(std::string_view raw_query, const SearchBudget& budget,
+                                                                DocumentPredicate document_predicate, const ScoringPolicy& scoring) const {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    METRICS_COUNT(MetricsCounter::QUERIES, 1);
+    BudgetedSearchResult result;
+    QueryContext context;
+    ParseQuery(raw_query, context);
+    const auto scorer = PrepareScoring(scoring);
+
+    auto& scored_postings = context.scored_postings;
+    for (std::string_view word : context.plus_words) {
+        const auto word_it = word_to_document_freqs_.find(word);
+        if (word_it != word_to_document_freqs_.end() && !word_it->second.empty()) {
+            scored_postings.emplace_back(&word_it->second, scorer.ComputeIdf(word_it->second.size()));
+        }
+    }
+    std::sort(scored_postings.begin(), scored_postings.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+
+    const auto is_budget_exhausted = [&budget, &result, &start] {
+        if (budget.max_postings != 0 && result.postings_scanned >= budget.max_postings) {
+            return true;
+        }
+        return budget.time_limit.count() != 0 && result.postings_scanned % BUDGET_CLOCK_CHECK_INTERVAL == 0
+            && Clock::now() - start >= budget.time_limit;
+    };
+    auto& document_to_relevance = context.document_to_relevance;
+    size_t accepted_count = 0;
+    {
+        METRICS_STAGE(MetricsStage::POSTING_TRAVERSAL);
+        for (auto it = scored_postings.begin(); it != scored_postings.end() && !result.is_approximate; ++it) {
+            const auto& [postings, IDF] = *it;
+            for (const auto [document_id, TF] : *postings) {
+                if (is_budget_exhausted()) {
+                    result.is_approximate = true;
+                    break;
+                }
+                ++result.postings_scanned;
                 const auto& document_data = documents_.at(document_id);
                 if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id].ref_to_value += TF * IDF;
+                    ++accepted_count;
+                    document_to_relevance.emplace_back(document_id,
+                        scorer.Score(TF, IDF, GetDocumentLength<ScoringPolicy>(document_id)));
                 }
             }
         }
+        CoalesceRelevance(document_to_relevance);
+    }
+    METRICS_COUNT(MetricsCounter::POSTINGS_SCANNED, result.postings_scanned);
+    METRICS_COUNT(MetricsCounter::POSTINGS_REJECTED, result.postings_scanned - accepted_count);
+
+    {
+        METRICS_STAGE(MetricsStage::MINUS_WORDS);
+        const auto contains = [this](std::string_view word, int document_id) {
+            const auto word_it = word_to_document_freqs_.find(word);
+            return word_it != word_to_document_freqs_.end() && word_it->second.count(document_id) > 0;
+        };
+        const bool has_phrases = !context.phrases.empty();
+        const bool has_phrase_terms = has_phrases && FindPhraseTerms(context.phrase_words, context.phrase_terms);
+        for (const auto& [document_id, relevance] : document_to_relevance) {
+            const bool has_required_words = std::all_of(context.required_words.begin(), context.required_words.end(),
+                [&](std::string_view word) { return contains(word, document_id); });
+            const bool has_minus_words = std::any_of(context.minus_words.begin(), context.minus_words.end(),
+                [&](std::string_view word) { return contains(word, document_id); });
+            const bool has_phrases_matched = !has_phrases
+                || (has_phrase_terms && MatchesPhrases(context.phrase_words, context.phrases, context.phrase_terms, document_id,
+                                                       context.phrase_positions));
+            if (has_required_words && !has_minus_words && has_phrases_matched) {
+                context.documents.emplace_back(document_id, relevance, documents_.at(document_id).rating);
+            }
+        }
+    }
+    SelectTopDocuments(context.documents);
+    METRICS_COUNT(MetricsCounter::EMPTY_RESULTS, context.documents.empty() ? 1 : 0);
+    METRICS_COUNT(MetricsCounter::APPROXIMATE_RESULTS, result.is_approximate ? 1 : 0);
+
+    result.documents = std::move(context.documents);
+    return result;
+}
+
+// шаблонный метод FindAllDocuments с передачей пользовательского предиката
+template <typename DocumentPredicate, typename ScoringPolicy>
+std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate,
+                                                     const ScoringPolicy& scoring) const {
+    return FindAllDocuments(std::execution::seq, query, document_predicate, scoring);
+}
+
+template<typename ExecutionPolicy, typename DocumentPredicate, typename ScoringPolicy>
+std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate,
+                                                     const ScoringPolicy& scoring) const {
+    // пересечение списков документов последовательно по своей природе
+    if (!query.required_words.empty()) {
+        QueryContext context;
+        context.plus_words = query.plus_words;
+        context.minus_words = query.minus_words;
+        context.required_words = query.required_words;
+        context.phrase_words = query.phrase_words;
+        context.phrases = query.phrases;
+        FindAllDocuments(context, document_predicate, scoring);
+        return std::move(context.documents);
+    }
+
+    const auto scorer = PrepareScoring(scoring);
+    // сумма длин списков документов плюс-слов ограничивает число ключей сверху: таблицы не придётся наращивать
+    size_t posting_count = 0;
+    for (std::string_view word : query.plus_words) {
+        if (const auto word_it = word_to_document_freqs_.find(word); word_it != word_to_document_freqs_.end()) {
+            posting_count += word_it->second.size();
+        }
+    }
+    ConcurrentMap<int, double> document_to_relevance(std::thread::hardware_concurrency(), std::min(posting_count, documents_.size()));
+    auto plus_words_processing = [&](std::string_view word) {
+        if (const auto word_it = word_to_document_freqs_.find(word); word_it != word_to_document_freqs_.end()) {
+            const double IDF = scorer.ComputeIdf(word_it->second.size());
+            ForEachMatchingPosting(word_it->second, document_predicate,
+                [&](int document_id, double TF) {
+                    document_to_relevance.FetchAdd(document_id, scorer.Score(TF, IDF, GetDocumentLength<ScoringPolicy>(document_id)));
+                });
+        }
     };
-    std::for_each(policy, query.plus_words.begin(), query.plus_words.end(), plus_words_processing);
+    {
+        METRICS_STAGE(MetricsStage::POSTING_TRAVERSAL);
+        std::for_each(policy, query.plus_words.begin(), query.plus_words.end(), plus_words_processing);
+    }
     
     auto minus_words_processing = [&](std::string_view word) {
         if (word_to_document_freqs_.count(word)) {
@@ -189,15 +945,365 @@ std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, c
             }
         }
     };
-    std::for_each(policy, query.minus_words.begin(), query.minus_words.end(), minus_words_processing);
+    {
+        METRICS_STAGE(MetricsStage::MINUS_WORDS);
+        std::for_each(policy, query.minus_words.begin(), query.minus_words.end(), minus_words_processing);
+    }
     
     std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
+    document_to_relevance.ForEach([&](int document_id, double relevance) {
         matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
-    }
+    });
+    // порядок по id делает порядок документов с равной релевантностью и рейтингом независимым от хешей
+    std::sort(matched_documents.begin(), matched_documents.end(),
+        [](const Document& lhs, const Document& rhs) { return lhs.id < rhs.id; });
     return matched_documents;
 }
 
+// вместо ConcurrentMap релевантность накапливается в векторе пар {id, вклад слова},
+// который затем сортируется по id и схлопывается; все буферы берутся из контекста
+template <typename DocumentPredicate, typename ScoringPolicy>
+void SearchServer::FindAllDocuments(QueryContext& context, DocumentPredicate document_predicate, const ScoringPolicy& scoring,
+                                    QueryExplanation* explanation) const {
+    FindAllDocuments(context, context.plus_words, context.minus_words, context.required_words, document_predicate, scoring,
+                     explanation);
+}
+
+template <typename Term, typename DocumentPredicate, typename ScoringPolicy>
+void SearchServer::FindAllDocuments(QueryContext& context, const std::vector<Term>& plus_terms, const std::vector<Term>& minus_terms,
+                                    const std::vector<Term>& required_terms, DocumentPredicate document_predicate,
+                                    const ScoringPolicy& scoring, QueryExplanation* explanation) const {
+    using Clock = std::chrono::steady_clock;
+    // часы опрашиваются только при разборе запроса
+    Clock::time_point phase_start;
+    if (explanation) {
+        phase_start = Clock::now();
+    }
+
+    const auto scorer = PrepareScoring(scoring);
+    auto& document_to_relevance = context.document_to_relevance;
+    document_to_relevance.clear();
+    if (!required_terms.empty()) {
+        METRICS_STAGE(MetricsStage::POSTING_TRAVERSAL);
+        const auto counts = FindConjunctiveDocuments(context, plus_terms, required_terms, document_predicate, scorer);
+        if (explanation) {
+            for (const Term& plus_term : plus_terms) {
+                const auto* postings = FindPostings(plus_term);
+                TermExplanation term{ std::string(GetTermWord(plus_term)) };
+                if (postings) {
+                    term.posting_count = postings->size();
+                    term.idf = ComputeTermIdf(scorer, plus_term, postings->size());
+                }
+                explanation->plus_terms.push_back(std::move(term));
+            }
+            explanation->postings_scanned = counts.scanned;
+            explanation->postings_rejected = counts.scanned - counts.accepted;
+        }
+    } else {
+        METRICS_STAGE(MetricsStage::POSTING_TRAVERSAL);
+        for (const Term& plus_term : plus_terms) {
+            const auto* postings = FindPostings(plus_term);
+            if (!postings) {
+                if (explanation) {
+                    explanation->plus_terms.push_back({ std::string(GetTermWord(plus_term)) });
+                }
+                continue;
+            }
+            const double IDF = ComputeTermIdf(scorer, plus_term, postings->size());
+            const auto counts = ForEachMatchingPosting(*postings, document_predicate, [&](int document_id, double TF) {
+                document_to_relevance.emplace_back(document_id, scorer.Score(TF, IDF, GetDocumentLength<ScoringPolicy>(document_id)));
+            });
+            if (explanation) {
+                explanation->plus_terms.push_back({ std::string(GetTermWord(plus_term)), postings->size(), IDF,
+                                                    counts.scanned, counts.scanned - counts.accepted });
+                explanation->postings_scanned += counts.scanned;
+                explanation->postings_rejected += counts.scanned - counts.accepted;
+            }
+        }
+        CoalesceRelevance(document_to_relevance);
+    }
+    if (explanation) {
+        const auto now = Clock::now();
+        explanation->posting_traversal_duration = now - phase_start;
+        phase_start = now;
+    }
+
+    METRICS_STAGE(MetricsStage::MINUS_WORDS);
+    auto& excluded_document_ids = context.excluded_document_ids;
+    excluded_document_ids.clear();
+    for (const Term& minus_term : minus_terms) {
+        const auto* postings = FindPostings(minus_term);
+        if (postings) {
+            for (const auto [document_id, freq] : *postings) {
+                excluded_document_ids.push_back(document_id);
+            }
+        }
+        if (explanation) {
+            TermExplanation term{ std::string(GetTermWord(minus_term)) };
+            term.posting_count = postings ? postings->size() : 0;
+            explanation->minus_terms.push_back(std::move(term));
+        }
+    }
+    std::sort(excluded_document_ids.begin(), excluded_document_ids.end());
+
+    context.documents.clear();
+    for (const auto& [document_id, relevance] : document_to_relevance) {
+        if (!std::binary_search(excluded_document_ids.begin(), excluded_document_ids.end(), document_id)) {
+            context.documents.emplace_back(document_id, relevance, documents_.at(document_id).rating);
+        }
+    }
+    if (explanation) {
+        explanation->documents_scored = document_to_relevance.size();
+        explanation->documents_excluded = document_to_relevance.size() - context.documents.size();
+        explanation->minus_words_duration = Clock::now() - phase_start;
+    }
+}
+
+// пересечение со скачками: кандидат берётся из самого короткого списка и ищется через lower_bound
+// в остальных; при промахе кандидатом становится первый больший id из списка, где случился промах,
+// и самый короткий список продолжается с него. Деревья списков дают скачок за O(log n) -
+// аналог галопирующего поиска в отсортированном массиве
+template <typename Term, typename DocumentPredicate, typename ScoringPolicy>
+SearchServer::PostingScanCounts SearchServer::FindConjunctiveDocuments(QueryContext& context, const std::vector<Term>& plus_terms,
+                                                                       const std::vector<Term>& required_terms,
+                                                                       DocumentPredicate& document_predicate,
+                                                                       const ScoringPolicy& scorer) const {
+    PostingScanCounts counts;
+    auto& required_postings = context.required_postings;
+    required_postings.clear();
+    for (const Term& required_term : required_terms) {
+        const auto* postings = FindPostings(required_term);
+        if (!postings || postings->empty()) {
+            return counts;
+        }
+        required_postings.push_back(postings);
+    }
+    std::sort(required_postings.begin(), required_postings.end(),
+        [](const auto* lhs, const auto* rhs) { return lhs->size() < rhs->size(); });
+    // слова фраз входят в обязательные слова: позиции проверяются только у документов из пересечения
+    const bool has_phrases = !context.phrases.empty();
+    if (has_phrases && !FindPhraseTerms(context.phrase_words, context.phrase_terms)) {
+        return counts;
+    }
+
+    auto& scored_postings = context.scored_postings;
+    scored_postings.clear();
+    for (const Term& plus_term : plus_terms) {
+        if (const auto* postings = FindPostings(plus_term)) {
+            scored_postings.emplace_back(postings, ComputeTermIdf(scorer, plus_term, postings->size()));
+        }
+    }
+
+    const auto& shortest_postings = *required_postings.front();
+    auto candidate_it = shortest_postings.begin();
+    while (candidate_it != shortest_postings.end()) {
+        const int candidate = candidate_it->first;
+        int next_candidate = candidate;
+        for (size_t i = 1; i < required_postings.size(); ++i) {
+            const auto it = required_postings[i]->lower_bound(candidate);
+            if (it == required_postings[i]->end()) {
+                METRICS_COUNT(MetricsCounter::POSTINGS_SCANNED, counts.scanned);
+                METRICS_COUNT(MetricsCounter::POSTINGS_REJECTED, counts.scanned - counts.accepted);
+                return counts;
+            }
+            if (it->first != candidate) {
+                next_candidate = it->first;
+                break;
+            }
+        }
+        if (next_candidate != candidate) {
+            candidate_it = shortest_postings.lower_bound(next_candidate);
+            continue;
+        }
+
+        ++counts.scanned;
+        const auto& document_data = documents_.at(candidate);
+        if (document_predicate(candidate, document_data.status, document_data.rating)
+            && (!has_phrases || MatchesPhrases(context.phrase_words, context.phrases, context.phrase_terms, candidate,
+                                               context.phrase_positions))) {
+            ++counts.accepted;
+            double relevance = 0.0;
+            for (const auto& [postings, IDF] : scored_postings) {
+                if (const auto it = postings->find(candidate); it != postings->end()) {
+                    relevance += scorer.Score(it->second, IDF, GetDocumentLength<ScoringPolicy>(candidate));
+                }
+            }
+            context.document_to_relevance.emplace_back(candidate, relevance);
+        }
+        ++candidate_it;
+    }
+    METRICS_COUNT(MetricsCounter::POSTINGS_SCANNED, counts.scanned);
+    METRICS_COUNT(MetricsCounter::POSTINGS_REJECTED, counts.scanned - counts.accepted);
+    return counts;
+}
+
+// документ вне всех списков лидеров набирает не больше суммы вкладов последних записей списков,
+// поэтому если пятый найденный документ выше этой границы хотя бы на EPSILON, выдача точна.
+// Для политик, учитывающих длину документа, порядок по TF не задаёт порядок вкладов, и они всегда
+// выполняются полным обходом
+template <typename Term, typename DocumentPredicate, typename ScoringPolicy>
+bool SearchServer::FindTopDocumentsByChampions(const std::vector<Term>& plus_terms,
+                                               const std::vector<Term>& minus_terms,
+                                               DocumentPredicate& document_predicate, const ScoringPolicy& scoring,
+                                               std::vector<int>& candidate_ids, std::vector<Document>& matched_documents) const {
+    if constexpr (ScoringPolicy::USES_DOCUMENT_LENGTH) {
+        return false;
+    } else {
+        if (plus_terms.empty() || plus_terms.size() > MAX_CHAMPION_QUERY_WORDS) {
+            return false;
+        }
+        const auto scorer = PrepareScoring(scoring);
+        std::array<std::pair<const std::pmr::map<int, double>*, double>, MAX_CHAMPION_QUERY_WORDS> scored_postings;
+        size_t scored_count = 0;
+        double outside_bound = 0.0;
+        bool has_truncated_list = false;
+        candidate_ids.clear();
+        for (const Term& plus_term : plus_terms) {
+            const auto* postings = FindPostings(plus_term);
+            if (!postings || postings->empty()) {
+                continue;
+            }
+            const double IDF = ComputeTermIdf(scorer, plus_term, postings->size());
+            scored_postings[scored_count++] = { postings, IDF };
+            const auto& champions = FindChampions(plus_term);
+            if (champions.size() < postings->size()) {
+                has_truncated_list = true;
+                outside_bound += scorer.Score(champions.back().term_frequency, IDF, 0);
+            }
+            for (const Champion& champion : champions) {
+                candidate_ids.push_back(champion.document_id);
+            }
+        }
+        if (!has_truncated_list) {
+            return false;
+        }
+        std::sort(candidate_ids.begin(), candidate_ids.end());
+        candidate_ids.erase(std::unique(candidate_ids.begin(), candidate_ids.end()), candidate_ids.end());
+
+        matched_documents.clear();
+        for (int document_id : candidate_ids) {
+            const auto& document_data = documents_.at(document_id);
+            if (!document_predicate(document_id, document_data.status, document_data.rating)) {
+                continue;
+            }
+            const bool is_excluded = std::any_of(minus_terms.begin(), minus_terms.end(), [&](const Term& minus_term) {
+                const auto* postings = FindPostings(minus_term);
+                return postings && postings->count(document_id) > 0;
+            });
+            if (is_excluded) {
+                continue;
+            }
+            double relevance = 0.0;
+            for (size_t i = 0; i < scored_count; ++i) {
+                const auto& [postings, IDF] = scored_postings[i];
+                if (const auto it = postings->find(document_id); it != postings->end()) {
+                    relevance += scorer.Score(it->second, IDF, 0);
+                }
+            }
+            matched_documents.emplace_back(document_id, relevance, document_data.rating);
+        }
+        SelectTopDocuments(matched_documents);
+
+        if (matched_documents.size() < MAX_RESULT_DOCUMENT_COUNT
+            || matched_documents.back().relevance < outside_bound + EPSILON) {
+            METRICS_COUNT(MetricsCounter::CHAMPION_FALLBACKS, 1);
+            return false;
+        }
+        METRICS_COUNT(MetricsCounter::CHAMPION_HITS, 1);
+        return true;
+    }
+}
+
+template <typename ScoringPolicy>
+ScoringPolicy SearchServer::PrepareScoring(const ScoringPolicy& scoring) const {
+    CorpusStats corpus;
+    corpus.document_count = documents_.size();
+    if (corpus.document_count != 0) {
+        corpus.average_document_length = total_document_length_ * 1.0 / corpus.document_count;
+    }
+    ScoringPolicy scorer = scoring;
+    scorer.Prepare(corpus);
+    return scorer;
+}
+
+template <typename ScoringPolicy>
+uint32_t SearchServer::GetDocumentLength(int document_id) const {
+    if constexpr (ScoringPolicy::USES_DOCUMENT_LENGTH) {
+        if (static_cast<size_t>(document_id) < dense_document_lengths_.size()) {
+            return dense_document_lengths_[document_id];
+        }
+        return documents_.at(document_id).length;
+    } else {
+        return 0;
+    }
+}
+
+template <typename DocumentPredicate, typename Callback>
+SearchServer::PostingScanCounts SearchServer::ForEachMatchingPosting(const std::pmr::map<int, double>& document_freqs,
+                                          DocumentPredicate& document_predicate, Callback callback) const {
+    size_t scanned_count = 0;
+    size_t accepted_count = 0;
+    auto accept = [&](int document_id, double TF) {
+        ++accepted_count;
+        callback(document_id, TF);
+    };
+    if constexpr (std::is_same_v<std::remove_const_t<DocumentPredicate>, DocumentFilter>) {
+        scanned_count = ForEachFilteredPosting(document_freqs, document_predicate, accept);
+    } else {
+        scanned_count = document_freqs.size();
+        for (const auto [document_id, TF] : document_freqs) {
+            const auto& document_data = documents_.at(document_id);
+            if (document_predicate(document_id, document_data.status, document_data.rating)) {
+                accept(document_id, TF);
+            }
+        }
+    }
+    METRICS_COUNT(MetricsCounter::POSTINGS_SCANNED, scanned_count);
+    METRICS_COUNT(MetricsCounter::POSTINGS_REJECTED, scanned_count - accepted_count);
+    return { scanned_count, accepted_count };
+}
+
+template <typename Callback>
+size_t SearchServer::ForEachFilteredPosting(const std::pmr::map<int, double>& document_freqs,
+                                            const DocumentFilter& filter, Callback callback) const {
+    // id документов неотрицательны, а битовая карта хранит их без знака, поэтому отрицательная
+    // нижняя граница заменяется нулём, а отрицательная верхняя даёт пустой диапазон
+    const int min_id = std::max(filter.min_id.value_or(0), 0);
+    const int max_id = filter.max_id.value_or(std::numeric_limits<int>::max());
+    if (max_id < 0 || min_id > max_id) {
+        return 0;
+    }
+    size_t scanned_count = 0;
+    const RoaringBitmap* status_document_ids = filter.status
+        ? &status_to_document_ids_[static_cast<size_t>(*filter.status)]
+        : nullptr;
+
+    // документов с нужным статусом мало - перебираем их и ищем каждый в списке документов слова
+    if (status_document_ids && status_document_ids->GetSize() * BITMAP_SCAN_RATIO < document_freqs.size()) {
+        status_document_ids->ForEachInRange(min_id, max_id, [&](uint32_t id) {
+            ++scanned_count;
+            const int document_id = static_cast<int>(id);
+            if (auto it = document_freqs.find(document_id);
+                it != document_freqs.end() && MatchesFilterAttributes(document_id, filter)) {
+                callback(document_id, it->second);
+            }
+        });
+        return scanned_count;
+    }
+
+    // иначе обходим только диапазон id списка, проверяя статус по битовой карте
+    const auto range_end = document_freqs.upper_bound(max_id);
+    for (auto it = document_freqs.lower_bound(min_id); it != range_end; ++it) {
+        ++scanned_count;
+        const auto [document_id, TF] = *it;
+        if ((!status_document_ids || status_document_ids->Contains(document_id))
+            && MatchesFilterAttributes(document_id, filter)) {
+            callback(document_id, TF);
+        }
+    }
+    return scanned_count;
+}
+
 template<typename ExecutionPolicy>
 matching_result SearchServer::MatchDocument(ExecutionPolicy&& policy, std::string_view raw_query, int document_id) const {
     // если вызвана последовательная политика - запускается метод без политик
@@ -208,6 +1314,7 @@ matching_result SearchServer::MatchDocument(ExecutionPolicy&& policy, std::strin
     if (!document_ids_.count(document_id)) {
         throw std::out_of_range("Requested id "s + std::to_string(document_id) + " is incorrect or doesn't exist"s);
     }
+    METRICS_STAGE(MetricsStage::MATCH_DOCUMENT);
     const auto query = ParseQuery(raw_query, false);
     if (std::any_of(policy,
         query.minus_words.begin(), query.minus_words.end(),
@@ -215,7 +1322,17 @@ matching_result SearchServer::MatchDocument(ExecutionPolicy&& policy, std::strin
             auto it = word_to_document_freqs_.find(word);
             return it != word_to_document_freqs_.end() && it->second.count(document_id);
         })) {
-        return { {}, documents_.at(document_id).status };
+        return { std::vector<std::string_view>{}, documents_.at(document_id).status };
+    }
+    // документ без хотя бы одного обязательного слова запросу не соответствует
+    if (!std::all_of(policy,
+        query.required_words.begin(), query.required_words.end(),
+        [&](std::string_view word) {
+            auto it = word_to_document_freqs_.find(word);
+            return it != word_to_document_freqs_.end() && it->second.count(document_id);
+        })
+        || !MatchesPhrases(query.phrase_words, query.phrases, document_id)) {
+        return { std::vector<std::string_view>{}, documents_.at(document_id).status };
     }
     
     std::vector<std::string_view> matched_words(query.plus_words.size());
@@ -242,26 +1359,41 @@ void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
     if (document_ids_.find(document_id) == document_ids_.end()) {
         throw std::invalid_argument("Requested id "s + std::to_string(document_id) + " is incorrect or doesn't exist"s);
     }
+    METRICS_STAGE(MetricsStage::REMOVE_DOCUMENT);
+    METRICS_COUNT(MetricsCounter::DOCUMENTS_REMOVED, 1);
     auto& word_freqs = document_to_word_freqs_.at(document_id);
-    std::vector<const std::string*> words_to_erase(word_freqs.size());
+    std::vector<std::string_view> words_to_erase(word_freqs.size());
     std::transform(policy,
         word_freqs.begin(), word_freqs.end(),
         words_to_erase.begin(),
         [](const auto& word_freq) {
-            return &(word_freq.first);
+            return word_freq.first;
         }
     );
+    if (positional_index_) {
+        positional_index_->Remove(document_id, words_to_erase);
+    }
     // итерируясь по вектору, удаляем записи в словаре word_to_document_freqs_
-    std::for_each(policy,
-        words_to_erase.begin(), words_to_erase.end(),
-        [&, document_id](const std::string* word_ptr) {
-            if (word_to_document_freqs_.count(*word_ptr) != 0) {
-                word_to_document_freqs_.at(*word_ptr).erase(document_id);
-            }
+    const auto erase_word = [&, document_id](std::string_view word) {
+        if (auto it = word_to_document_freqs_.find(word); it != word_to_document_freqs_.end()) {
+            it->second.erase(document_id);
+            RemoveChampion(word, it->second, document_id);
         }
-    );
-    // 2/3: удаление документа из словаря documents_
+    };
+    // узлы освобождаются в ресурс сервера: параллельно - только в потокобезопасную кучу
+    if (word_to_document_freqs_.get_allocator().resource()->is_equal(*std::pmr::new_delete_resource())) {
+        std::for_each(policy, words_to_erase.begin(), words_to_erase.end(), erase_word);
+    } else {
+        std::for_each(words_to_erase.begin(), words_to_erase.end(), erase_word);
+    }
+    // 2/3: удаление документа из словаря documents_ и битовой карты его статуса
+    status_to_document_ids_[static_cast<size_t>(documents_.at(document_id).status)].Remove(document_id);
+    total_document_length_ -= documents_.at(document_id).length;
     documents_.erase(document_id);
+    if (document_store_) {
+        document_store_->Remove(document_id);
+    }
     // 3/3: удаление документа из контейнера id документов
     document_ids_.erase(document_id);
+    ++index_version_;
 }
\ No newline at end of file
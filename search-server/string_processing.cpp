@@ -1,17 +1,27 @@
 #include "string_processing.h"
 
+#include <array>
+#include <cassert>
+#include <cstdint>
+
 std::vector<std::string_view> SplitIntoWords(std::string_view str) {
     std::vector<std::string_view> result;
+    SplitIntoWords(str, result);
+    return result;
+}
+
+void SplitIntoWords(std::string_view str, std::vector<std::string_view>& result) {
+    result.clear();
     
     // обработка строк без слов
     if (str.empty() || str.find_first_not_of(' ') == str.npos) {
-        return result;
+        return;
     }
     
     // обработка строк из одного слова
     if (str.find_first_of(' ') == str.npos) {
         result.push_back(str.substr(0));
-        return result;
+        return;
     }
     
     // удаление пробелов перед первым словом
@@ -25,13 +35,73 @@ std::vector<std::string_view> SplitIntoWords(std::string_view str) {
         // последнее слово в строке
         if (space == str.npos) {
             result.push_back(str.substr(0));
-            return result;
+            return;
         }
         else {
             result.push_back(str.substr(0, space));
             str.remove_prefix(std::min(str.size(), str.find_first_not_of(' ', space)));
         }
     }
-    
-    return result;
+}
+
+// жадное сопоставление с возвратом к последней '*': при несовпадении она поглощает ещё один символ
+bool MatchesWildcard(std::string_view pattern, std::string_view word) {
+    size_t pattern_pos = 0;
+    size_t word_pos = 0;
+    size_t star_pos = pattern.npos;
+    size_t star_word_pos = 0;
+    while (word_pos < word.size()) {
+        if (pattern_pos < pattern.size() && pattern[pattern_pos] == '*') {
+            star_pos = pattern_pos++;
+            star_word_pos = word_pos;
+        } else if (pattern_pos < pattern.size() && pattern[pattern_pos] == word[word_pos]) {
+            ++pattern_pos;
+            ++word_pos;
+        } else if (star_pos != pattern.npos) {
+            pattern_pos = star_pos + 1;
+            word_pos = ++star_word_pos;
+        } else {
+            return false;
+        }
+    }
+    while (pattern_pos < pattern.size() && pattern[pattern_pos] == '*') {
+        ++pattern_pos;
+    }
+    return pattern_pos == pattern.size();
+}
+
+// битово-параллельный алгоритм Майерса в варианте Хююрё: столбец матрицы расстояний хранится
+// битовыми масками положительных (pv) и отрицательных (mv) разностей соседних строк,
+// а обработка очередного символа word занимает несколько побитовых операций
+size_t ComputeEditDistance(std::string_view pattern, std::string_view word) {
+    assert(pattern.size() <= MAX_EDIT_DISTANCE_PATTERN_LENGTH);
+    if (pattern.empty()) {
+        return word.size();
+    }
+    std::array<uint64_t, 256> char_masks{};
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char_masks[static_cast<unsigned char>(pattern[i])] |= uint64_t{1} << i;
+    }
+    const uint64_t last_bit = uint64_t{1} << (pattern.size() - 1);
+    uint64_t pv = ~uint64_t{0};
+    uint64_t mv = 0;
+    size_t distance = pattern.size();
+    for (char c : word) {
+        const uint64_t eq = char_masks[static_cast<unsigned char>(c)];
+        const uint64_t xv = eq | mv;
+        const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & last_bit) {
+            ++distance;
+        } else if (mh & last_bit) {
+            --distance;
+        }
+        // расстояние в нулевой строке растёт на единицу с каждым символом word
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return distance;
 }
\ No newline at end of file
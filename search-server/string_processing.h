@@ -5,6 +5,18 @@
 
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
+// разбиение строки на слова с записью в переиспользуемый буфер
+void SplitIntoWords(std::string_view text, std::vector<std::string_view>& words);
+
+// соответствие слова шаблону, в котором '*' обозначает любую (в том числе пустую) последовательность символов
+bool MatchesWildcard(std::string_view pattern, std::string_view word);
+
+// наибольшая длина pattern в ComputeEditDistance: столбец матрицы расстояний помещается в 64-битное слово
+const size_t MAX_EDIT_DISTANCE_PATTERN_LENGTH = 64;
+
+// расстояние Левенштейна (вставка, удаление, замена символа) между pattern и word
+size_t ComputeEditDistance(std::string_view pattern, std::string_view word);
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> SplitIntoStrings(const StringContainer& text) {
     std::set<std::string, std::less<>> strings;
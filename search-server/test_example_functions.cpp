@@ -1,5 +1,15 @@
 #include "test_example_functions.h"
 
+#include <limits>
+#include <memory>
+#include <memory_resource>
+
+#include "allocation_counter.h"
+#include "impact_index.h"
+#include "paginator.h"
+#include "process_queries.h"
+#include "request_stats.h"
+
 void AssertImpl(bool value, const std::string& str, const std::string& file, const std::string& func, unsigned line, const std::string& hint) {
     if (!value) {
         std::cout << file << "("s << line << "): "s << func << ": "s;
@@ -177,17 +187,1355 @@ void TestFilteringResultsByUserDefinedPredicate() {
 
     // убеждаемся, что найден один документ со статусом BANNED
     const auto found_docs_banned = server.FindTopDocuments("fluffy well-groomed cat"s,
-        [](int document_id, DocumentStatus status, int rating) { return status == DocumentStatus::BANNED; });
+        [](int, DocumentStatus status, int) { return status == DocumentStatus::BANNED; });
     ASSERT_EQUAL_HINT(found_docs_banned.size(), 1u,
         "Invalid number of found documents with this status"s);
 
     // убеждаемся, что найдено два документа с чётными id
     const auto found_docs_even_ids = server.FindTopDocuments("fluffy well-groomed cat"s,
-        [](int document_id, DocumentStatus status, int rating) { return document_id % 2 == 0; });
+        [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; });
     ASSERT_EQUAL_HINT(found_docs_even_ids.size(), 2u,
         "Invalid number of found documents filteted using a user-defined predicate"s);
 }
 
+void TestQueryContextSearchIsAllocationFree() {
+    SearchServer server("and"s);
+    server.AddDocument(0, "white cat and long tail"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "well-groomed dog talking eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+    server.AddDocument(3, "well-groomed starling Eugene"s, DocumentStatus::BANNED, { 9 });
+    server.AddDocument(4, "fluffy dog and fluffy cat"s, DocumentStatus::ACTUAL, { 4 });
+
+    const std::string_view query = "fluffy well-groomed cat tail -eyes"sv;
+    const auto expected_docs = server.FindTopDocuments(query);
+
+    QueryContext context;
+    const auto& found_docs = server.FindTopDocuments(context, query);
+    ASSERT_EQUAL_HINT(found_docs.size(), expected_docs.size(),
+        "Search with a query context must return the same documents"s);
+    for (size_t i = 0; i < found_docs.size(); ++i) {
+        ASSERT_EQUAL(found_docs[i].id, expected_docs[i].id);
+        ASSERT(std::abs(found_docs[i].relevance - expected_docs[i].relevance) < EPSILON);
+    }
+
+    // после прогрева буферов контекста повторные запросы не выделяют память
+    server.FindTopDocuments(context, "cat -fluffy"sv, DocumentStatus::ACTUAL);
+    const size_t allocations_before = GetAllocationCount();
+    for (int i = 0; i < 100; ++i) {
+        server.FindTopDocuments(context, query);
+        server.FindTopDocuments(context, "cat -fluffy"sv, DocumentStatus::ACTUAL);
+    }
+    const size_t allocations_after = GetAllocationCount();
+    ASSERT_EQUAL_HINT(allocations_after - allocations_before, 0u,
+        "Steady-state queries with a query context must not allocate memory"s);
+}
+
+void TestIndexStats() {
+    SearchServer server("and with"s);
+    const IndexStats empty_stats = server.GetIndexStats();
+    ASSERT_EQUAL(empty_stats.term_count, 0u);
+    ASSERT_EQUAL(empty_stats.total_postings, 0u);
+    ASSERT(empty_stats.posting_list_length_histogram.empty());
+    ASSERT(empty_stats.stop_words_bytes > 0);
+
+    server.AddDocument(0, "white cat and long tail"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "well-groomed dog with long eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+    const IndexStats stats = server.GetIndexStats();
+    // white cat long tail fluffy well-groomed dog eyes
+    ASSERT_EQUAL(stats.term_count, 8u);
+    // 4 + 3 + 4 записи {слово, документ}
+    ASSERT_EQUAL(stats.total_postings, 11u);
+    ASSERT_EQUAL(stats.max_posting_list_length, 2u);
+    ASSERT(std::abs(stats.average_posting_list_length - 11.0 / 8.0) < EPSILON);
+    // 5 слов встречаются в одном документе, 3 слова (cat, long, tail) - в двух
+    ASSERT_EQUAL(stats.posting_list_length_histogram.size(), 2u);
+    ASSERT_EQUAL(stats.posting_list_length_histogram[0], 5u);
+    ASSERT_EQUAL(stats.posting_list_length_histogram[1], 3u);
+    ASSERT(stats.term_dictionary_bytes > 0 && stats.postings_bytes > 0);
+    ASSERT(stats.forward_index_bytes > 0 && stats.document_table_bytes > 0);
+    ASSERT_EQUAL(stats.stop_words_bytes, empty_stats.stop_words_bytes);
+    ASSERT(stats.GetTotalBytes() > empty_stats.GetTotalBytes());
+
+    server.RemoveDocument(1);
+    const IndexStats stats_after_remove = server.GetIndexStats();
+    ASSERT_EQUAL(stats_after_remove.total_postings, 8u);
+    ASSERT(stats_after_remove.postings_bytes < stats.postings_bytes);
+    ASSERT(stats_after_remove.forward_index_bytes < stats.forward_index_bytes);
+}
+
+void TestRoaringBitmap() {
+    RoaringBitmap bitmap;
+    ASSERT_EQUAL(bitmap.GetSize(), 0u);
+    ASSERT(!bitmap.Contains(0));
+
+    // значения в разных группах по старшим 16 битам
+    bitmap.Add(7);
+    bitmap.Add(70'000);
+    bitmap.Add(7);
+    ASSERT_EQUAL(bitmap.GetSize(), 2u);
+    ASSERT(bitmap.Contains(7) && bitmap.Contains(70'000) && !bitmap.Contains(8));
+
+    // переполнение массива переводит группу в битовую карту
+    for (uint32_t value = 0; value < 10'000; value += 2) {
+        bitmap.Add(value);
+    }
+    ASSERT_EQUAL(bitmap.GetSize(), 5'002u);
+    ASSERT(bitmap.Contains(9'998) && !bitmap.Contains(9'999));
+
+    std::vector<uint32_t> values;
+    bitmap.ForEachInRange(9'990, 70'000, [&values](uint32_t value) { values.push_back(value); });
+    const std::vector<uint32_t> expected_values = { 9'990, 9'992, 9'994, 9'996, 9'998, 70'000 };
+    ASSERT(values == expected_values);
+
+    // после удаления группа возвращается к массиву без потери значений
+    for (uint32_t value = 100; value < 10'000; value += 2) {
+        bitmap.Remove(value);
+    }
+    bitmap.Remove(70'000);
+    bitmap.Remove(70'001);
+    ASSERT_EQUAL(bitmap.GetSize(), 51u);
+    ASSERT(bitmap.Contains(98) && !bitmap.Contains(100) && !bitmap.Contains(70'000));
+    size_t visited = 0;
+    bitmap.ForEachInRange(0, std::numeric_limits<uint32_t>::max(), [&visited](uint32_t) { ++visited; });
+    ASSERT_EQUAL(visited, 51u);
+
+    // все контейнеры, включая массивы и битовые карты групп, берут память из заданного ресурса
+    std::vector<std::byte> buffer(1 << 20);
+    std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    RoaringBitmap resource_bitmap(&resource);
+    const size_t allocations_before = GetAllocationCount();
+    for (uint32_t value = 0; value < 200'000; value += 3) {
+        resource_bitmap.Add(value);
+    }
+    resource_bitmap.Remove(3);
+    const size_t allocations_after = GetAllocationCount();
+    ASSERT_EQUAL_HINT(allocations_after - allocations_before, 0u,
+        "Roaring bitmap must allocate only from its memory resource"s);
+    ASSERT(resource_bitmap.Contains(6) && !resource_bitmap.Contains(3));
+}
+
+void TestFilteringResultsByDocumentFilter() {
+    SearchServer server("and"s);
+    server.AddDocument(0, "white cat and long tail"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "well-groomed dog talking eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+    server.AddDocument(3, "well-groomed starling Eugene"s, DocumentStatus::BANNED, { 9 });
+    server.AddDocument(4, "fluffy cat with fluffy eyes"s, DocumentStatus::IRRELEVANT, { 3 });
+    server.AddDocument(5, "cat and dog"s, DocumentStatus::BANNED, { -1 });
+    // длинные списки документов слов cat и dog, чтобы фильтр по редкому статусу перебирал битовую карту
+    for (int document_id = 100; document_id < 140; ++document_id) {
+        server.AddDocument(document_id, "cat in a house with a dog"s, DocumentStatus::ACTUAL, { document_id % 7 });
+    }
+
+    const std::string query = "fluffy well-groomed cat dog"s;
+    const std::vector<DocumentFilter> filters = {
+        DocumentFilter{},
+        DocumentFilter::ByStatus(DocumentStatus::ACTUAL),
+        DocumentFilter::ByStatus(DocumentStatus::BANNED),
+        DocumentFilter::ByStatus(DocumentStatus::IRRELEVANT),
+        DocumentFilter::ByStatus(DocumentStatus::REMOVED),
+        DocumentFilter{ std::nullopt, 2 },
+        DocumentFilter{ DocumentStatus::ACTUAL, std::nullopt, 2 },
+        DocumentFilter{ std::nullopt, std::nullopt, std::nullopt, 1, 4 },
+        DocumentFilter{ DocumentStatus::BANNED, std::nullopt, std::nullopt, 4 },
+        // отрицательные границы id: с редким статусом поиск идёт по битовой карте, с частым - по спискам
+        DocumentFilter{ DocumentStatus::BANNED, std::nullopt, std::nullopt, -5 },
+        DocumentFilter{ DocumentStatus::BANNED, std::nullopt, std::nullopt, -5, -1 },
+        DocumentFilter{ DocumentStatus::ACTUAL, std::nullopt, std::nullopt, -5, 3 },
+        DocumentFilter{ std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, DocumentFilter::IdParity::EVEN },
+        DocumentFilter{ std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, DocumentFilter::IdParity::ODD },
+    };
+    for (const DocumentFilter& filter : filters) {
+        // лямбда скрывает фильтр от сервера, поэтому поиск идёт общим путём с предикатом
+        const auto expected_docs = server.FindTopDocuments(query,
+            [&filter](int document_id, DocumentStatus status, int rating) { return filter(document_id, status, rating); });
+        const auto found_docs = server.FindTopDocuments(query, filter);
+        const auto found_docs_par = server.FindTopDocuments(std::execution::par, query, filter);
+        ASSERT_EQUAL(found_docs.size(), expected_docs.size());
+        ASSERT_EQUAL(found_docs_par.size(), expected_docs.size());
+        for (size_t i = 0; i < found_docs.size(); ++i) {
+            ASSERT_EQUAL(found_docs[i].id, expected_docs[i].id);
+            ASSERT_EQUAL(found_docs_par[i].id, expected_docs[i].id);
+        }
+    }
+
+    const DocumentFilter negative_min_id{ DocumentStatus::BANNED, std::nullopt, std::nullopt, -5 };
+    ASSERT_EQUAL(server.FindTopDocuments(query, negative_min_id).size(), 2u);
+
+    // после удаления документ пропадает из битовой карты статуса
+    ASSERT_EQUAL(server.FindTopDocuments(query, DocumentStatus::BANNED).size(), 2u);
+    server.RemoveDocument(5);
+    ASSERT_EQUAL(server.FindTopDocuments(query, DocumentStatus::BANNED).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments(query, DocumentStatus::REMOVED).size(), 0u);
+}
+
+void TestScoringPolicies() {
+    SearchServer server("and"s);
+    server.AddDocument(0, "white cat and long tail"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "well-groomed dog talking eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+    server.AddDocument(3, "cat"s, DocumentStatus::ACTUAL, { 1 });
+    const std::string query = "fluffy cat"s;
+
+    // TF-IDF не зависит от длины документа: документ №0 с частотой 1/4 ниже документа №3 с частотой 1
+    const auto tf_idf_docs = server.FindTopDocuments(query, DocumentFilter{}, TfIdfScoring());
+    const auto default_docs = server.FindTopDocuments(query);
+    ASSERT_EQUAL(tf_idf_docs.size(), 3u);
+    ASSERT_EQUAL(default_docs.size(), 3u);
+    const std::vector<double> expected_tf_idf_relevance = { 0.765068, 0.287682, 0.071921 };
+    for (size_t i = 0; i < tf_idf_docs.size(); ++i) {
+        ASSERT_EQUAL(tf_idf_docs[i].id, default_docs[i].id);
+        ASSERT(std::abs(tf_idf_docs[i].relevance - expected_tf_idf_relevance[i]) < EPSILON);
+    }
+
+    // BM25 с k1 = 1.2, b = 0.75 и средней длиной документа 13/4
+    const std::vector<int> expected_bm25_ids = { 1, 3, 0 };
+    const std::vector<double> expected_bm25_relevance = { 1.880473, 0.497605, 0.325907 };
+    QueryContext context;
+    const auto bm25_docs = server.FindTopDocuments(query, DocumentFilter::ByStatus(DocumentStatus::ACTUAL), Bm25Scoring());
+    const auto bm25_docs_par = server.FindTopDocuments(std::execution::par, query, DocumentFilter{}, Bm25Scoring());
+    const auto bm25_docs_context = server.FindTopDocuments(context, query, DocumentFilter{}, Bm25Scoring());
+    ASSERT_EQUAL(bm25_docs.size(), 3u);
+    ASSERT_EQUAL(bm25_docs_par.size(), 3u);
+    ASSERT_EQUAL(bm25_docs_context.size(), 3u);
+    for (size_t i = 0; i < bm25_docs.size(); ++i) {
+        ASSERT_EQUAL(bm25_docs[i].id, expected_bm25_ids[i]);
+        ASSERT_EQUAL(bm25_docs_par[i].id, expected_bm25_ids[i]);
+        ASSERT_EQUAL(bm25_docs_context[i].id, expected_bm25_ids[i]);
+        ASSERT_HINT(std::abs(bm25_docs[i].relevance - expected_bm25_relevance[i]) < EPSILON,
+            "Wrong calculation of BM25 relevance"s);
+    }
+
+    // после удаления документа средняя длина пересчитывается
+    server.RemoveDocument(3);
+    const auto bm25_docs_after_remove = server.FindTopDocuments(query, DocumentFilter::ByStatus(DocumentStatus::ACTUAL), Bm25Scoring());
+    ASSERT_EQUAL(bm25_docs_after_remove.size(), 2u);
+    ASSERT_EQUAL(bm25_docs_after_remove[0].id, 1);
+
+    // длина документа с большим id берётся из его свойств: массив длин по id до него не растёт
+    const int large_id = 2'000'000'000;
+    server.AddDocument(large_id, "cat"s, DocumentStatus::ACTUAL, { 1 });
+    const auto bm25_docs_large_id = server.FindTopDocuments(query, DocumentFilter::ByStatus(DocumentStatus::ACTUAL), Bm25Scoring());
+    ASSERT_EQUAL(bm25_docs_large_id.size(), 3u);
+    ASSERT_EQUAL(bm25_docs_large_id[1].id, large_id);
+    ASSERT(std::abs(bm25_docs_large_id[1].relevance - expected_bm25_relevance[1]) < EPSILON);
+
+    // при добавлении по убыванию id длины документов сначала берутся из свойств, а по мере роста
+    // числа документов переносятся в массив; выдача совпадает с добавлением по возрастанию id
+    SearchServer ascending_server("and"s);
+    SearchServer descending_server("and"s);
+    const int length_count = 3000;
+    const auto length_text = [](int id) {
+        std::string text = id % 2 == 0 ? "cat"s : "dog"s;
+        for (int i = 0; i < id % 5; ++i) {
+            text += " tail"s;
+        }
+        return text;
+    };
+    for (int id = 0; id < length_count; ++id) {
+        ascending_server.AddDocument(id, length_text(id), DocumentStatus::ACTUAL, { id % 7 });
+        descending_server.AddDocument(length_count - 1 - id, length_text(length_count - 1 - id), DocumentStatus::ACTUAL,
+                                      { (length_count - 1 - id) % 7 });
+    }
+    const auto ascending_docs = ascending_server.FindTopDocuments("cat"s, DocumentFilter::ByStatus(DocumentStatus::ACTUAL), Bm25Scoring());
+    const auto descending_docs = descending_server.FindTopDocuments("cat"s, DocumentFilter::ByStatus(DocumentStatus::ACTUAL), Bm25Scoring());
+    ASSERT_EQUAL(descending_docs.size(), ascending_docs.size());
+    for (size_t i = 0; i < ascending_docs.size(); ++i) {
+        ASSERT_EQUAL(descending_docs[i].id, ascending_docs[i].id);
+        ASSERT_EQUAL(descending_docs[i].relevance, ascending_docs[i].relevance);
+    }
+}
+
+void TestMetrics() {
+    // значения до 32 хранятся точно, дальше корзина покрывает 1/16 интервала [2^k, 2^(k+1))
+    for (uint64_t value : { 0u, 1u, 31u, 32u, 33u, 100u, 1000u, 123456u }) {
+        const size_t index = LatencyHistogram::GetBucketIndex(value);
+        ASSERT(LatencyHistogram::GetBucketUpperBound(index) >= value);
+        ASSERT(index == 0 || LatencyHistogram::GetBucketUpperBound(index - 1) < value);
+    }
+    ASSERT_EQUAL(LatencyHistogram::GetBucketUpperBound(LatencyHistogram::GetBucketIndex(31)), 31u);
+    ASSERT_EQUAL(LatencyHistogram::GetBucketUpperBound(LatencyHistogram::GetBucketIndex(1000)), 1023u);
+
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.Record(value);
+    }
+    ASSERT_EQUAL(histogram.GetCount(), 1000u);
+    ASSERT_EQUAL(histogram.GetMax(), 1000u);
+    ASSERT(std::abs(histogram.GetMean() - 500.5) < EPSILON);
+    const uint64_t p50 = histogram.GetPercentile(0.5);
+    ASSERT_HINT(p50 >= 500 && p50 <= 500 + 500 / 16, "Percentile must be within the bucket precision"s);
+    ASSERT_EQUAL(histogram.GetPercentile(1.0), 1000u);
+
+#ifndef SEARCH_SERVER_DISABLE_METRICS
+    ResetMetrics();
+    SearchServer server("and in on"s);
+    server.AddDocument(0, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "well-groomed dog expressive eyes"s, DocumentStatus::BANNED, { 5, -12, 2, 1 });
+    server.FindTopDocuments("fluffy cat"s);
+    server.FindTopDocuments(std::execution::par, "fluffy cat"s);
+    server.FindTopDocuments("parrot"s);
+    server.MatchDocument("fluffy cat"s, 1);
+    server.RemoveDocument(2);
+
+    const auto metrics = CollectMetrics();
+    const auto counter = [&metrics](MetricsCounter name) {
+        return metrics.counters[static_cast<size_t>(name)];
+    };
+    const auto stage_count = [&metrics](MetricsStage stage) {
+        return metrics.stage_latencies[static_cast<size_t>(stage)].GetCount();
+    };
+    ASSERT_EQUAL(counter(MetricsCounter::QUERIES), 3u);
+    ASSERT_EQUAL(counter(MetricsCounter::EMPTY_RESULTS), 1u);
+    ASSERT_EQUAL(counter(MetricsCounter::DOCUMENTS_ADDED), 3u);
+    ASSERT_EQUAL(counter(MetricsCounter::DOCUMENTS_REMOVED), 1u);
+    // «cat» встречается в двух документах, «fluffy» в одном, каждый запрос проходит три записи
+    ASSERT_EQUAL(counter(MetricsCounter::POSTINGS_SCANNED), 6u);
+    ASSERT_EQUAL(counter(MetricsCounter::POSTINGS_REJECTED), 0u);
+    ASSERT_EQUAL(stage_count(MetricsStage::PARSE_QUERY), 4u);
+    ASSERT_EQUAL(stage_count(MetricsStage::POSTING_TRAVERSAL), 3u);
+    ASSERT_EQUAL(stage_count(MetricsStage::TOP_K), 3u);
+    ASSERT_EQUAL(stage_count(MetricsStage::MATCH_DOCUMENT), 1u);
+    ASSERT_EQUAL(stage_count(MetricsStage::ADD_DOCUMENT), 3u);
+    ASSERT_EQUAL(stage_count(MetricsStage::REMOVE_DOCUMENT), 1u);
+
+    // отвергнутые предикатом записи учитываются отдельно
+    ResetMetrics();
+    server.FindTopDocuments("fluffy cat"s, [](int document_id, DocumentStatus, int) { return document_id != 0; });
+    ASSERT_EQUAL(CollectMetrics().counters[static_cast<size_t>(MetricsCounter::POSTINGS_REJECTED)], 1u);
+#endif
+}
+
+void TestExplainTopDocuments() {
+    SearchServer server("and in on"s);
+    server.AddDocument(0, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "well-groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+    server.AddDocument(3, "groomed cat with collar"s, DocumentStatus::BANNED, { 9 });
+    const std::string query = "fluffy groomed cat parrot -collar"s;
+
+    const auto explanation = server.ExplainTopDocuments(query);
+    const auto documents = server.FindTopDocuments(query);
+    ASSERT_EQUAL(explanation.documents.size(), documents.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        ASSERT_EQUAL(explanation.documents[i].id, documents[i].id);
+        ASSERT(std::abs(explanation.documents[i].relevance - documents[i].relevance) < EPSILON);
+    }
+
+    // слова упорядочены по возрастанию, отсутствующее в индексе слово сохраняется с пустым списком
+    ASSERT_EQUAL(explanation.plus_terms.size(), 4u);
+    ASSERT_EQUAL(explanation.plus_terms[0].word, "cat"s);
+    ASSERT_EQUAL(explanation.plus_terms[0].posting_count, 3u);
+    ASSERT(std::abs(explanation.plus_terms[0].idf - std::log(4.0 / 3.0)) < EPSILON);
+    ASSERT_EQUAL(explanation.plus_terms[0].postings_scanned, 3u);
+    ASSERT_EQUAL(explanation.plus_terms[0].postings_rejected, 1u);
+    ASSERT_EQUAL(explanation.plus_terms[2].word, "groomed"s);
+    ASSERT_EQUAL(explanation.plus_terms[2].postings_rejected, 1u);
+    ASSERT_EQUAL(explanation.plus_terms[3].word, "parrot"s);
+    ASSERT_EQUAL(explanation.plus_terms[3].posting_count, 0u);
+    ASSERT_EQUAL(explanation.minus_terms.size(), 1u);
+    ASSERT_EQUAL(explanation.minus_terms[0].posting_count, 2u);
+
+    ASSERT_EQUAL(explanation.postings_scanned, 5u);
+    ASSERT_EQUAL(explanation.postings_rejected, 2u);
+    // документы №0 и №1 получили релевантность, №0 исключён минус-словом
+    ASSERT_EQUAL(explanation.documents_scored, 2u);
+    ASSERT_EQUAL(explanation.documents_excluded, 1u);
+    ASSERT_EQUAL(explanation.documents.size(), 1u);
+    ASSERT_EQUAL(explanation.documents[0].id, 1);
+}
+
+void TestDeepPagination() {
+    SearchServer server("and in on"s);
+    // документы с одинаковой релевантностью и рейтингом упорядочиваются по id
+    for (int id = 0; id < 40; ++id) {
+        const std::string text = id % 3 == 0 ? "fluffy cat"s : (id % 3 == 1 ? "cat with long tail"s : "groomed dog"s);
+        server.AddDocument(id, text, DocumentStatus::ACTUAL, { id % 4 });
+    }
+    const std::string query = "fluffy cat"s;
+    const auto all_documents = server.FindDocumentsPage(query, 0, 1000).documents;
+    ASSERT_EQUAL(all_documents.size(), 27u);
+    for (size_t i = 1; i < all_documents.size(); ++i) {
+        ASSERT(!(all_documents[i].relevance > all_documents[i - 1].relevance + EPSILON));
+    }
+    // первая страница согласована с топ-5; порядок FindTopDocuments при полном совпадении не определён
+    const auto top_documents = server.FindTopDocuments(query);
+    for (size_t i = 0; i < top_documents.size(); ++i) {
+        ASSERT(std::abs(top_documents[i].relevance - all_documents[i].relevance) < EPSILON);
+        ASSERT_EQUAL(top_documents[i].rating, all_documents[i].rating);
+    }
+
+    const size_t page_size = 4;
+    std::vector<int> offset_ids;
+    for (size_t offset = 0; offset < all_documents.size(); offset += page_size) {
+        for (const Document& document : server.FindDocumentsPage(query, offset, page_size).documents) {
+            offset_ids.push_back(document.id);
+        }
+    }
+
+    std::vector<int> cursor_ids;
+    std::string cursor;
+    do {
+        const auto page = server.FindDocumentsPageAfter(query, cursor, page_size);
+        ASSERT(page.documents.size() <= page_size);
+        for (const Document& document : page.documents) {
+            cursor_ids.push_back(document.id);
+        }
+        cursor = page.next_cursor;
+    } while (!cursor.empty());
+
+    std::vector<int> lazy_ids;
+    size_t page_count = 0;
+    const auto pages = PaginateLazily([&server, &query](const std::string& page_cursor, size_t size) {
+        return server.FindDocumentsPageAfter(query, page_cursor, size);
+    }, page_size);
+    for (const auto& page : pages) {
+        ++page_count;
+        for (auto it = page.GetRangeBegin(); it != page.GetRangeEnd(); ++it) {
+            lazy_ids.push_back(it->id);
+        }
+    }
+    ASSERT_EQUAL(page_count, 7u);
+
+    ASSERT_EQUAL(offset_ids.size(), all_documents.size());
+    for (size_t i = 0; i < all_documents.size(); ++i) {
+        ASSERT_EQUAL(offset_ids[i], all_documents[i].id);
+        ASSERT_EQUAL(cursor_ids[i], all_documents[i].id);
+        ASSERT_EQUAL(lazy_ids[i], all_documents[i].id);
+    }
+
+    // смещение за концом выдачи даёт пустую страницу без курсора
+    const auto past_end = server.FindDocumentsPage(query, 100, page_size);
+    ASSERT(past_end.documents.empty() && past_end.next_cursor.empty());
+    bool invalid_cursor_rejected = false;
+    try {
+        server.FindDocumentsPageAfter(query, "not a cursor"s, page_size);
+    } catch (const std::invalid_argument&) {
+        invalid_cursor_rejected = true;
+    }
+    ASSERT(invalid_cursor_rejected);
+
+    // релевантности, попарно близкие в пределах EPSILON, но не равные, упорядочиваются точно,
+    // несмотря на обратный порядок рейтингов, и страницы на их границах не повторяют и не пропускают документы
+    SearchServer close_server("and in on"s);
+    const int close_count = 12;
+    for (int id = 0; id < close_count; ++id) {
+        std::string text = "cat"s;
+        for (int i = 1; i < 2000 + id; ++i) {
+            text += " tail"s;
+        }
+        close_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id });
+        close_server.AddDocument(close_count + id, "dog"s, DocumentStatus::ACTUAL, { 0 });
+    }
+    const auto close_documents = close_server.FindDocumentsPage("cat"s, 0, 100).documents;
+    ASSERT_EQUAL(close_documents.size(), static_cast<size_t>(close_count));
+    ASSERT(close_documents.front().relevance - close_documents.back().relevance > EPSILON);
+    std::vector<int> close_ids;
+    cursor.clear();
+    do {
+        const auto page = close_server.FindDocumentsPageAfter("cat"s, cursor, 5);
+        for (const Document& document : page.documents) {
+            close_ids.push_back(document.id);
+        }
+        cursor = page.next_cursor;
+    } while (!cursor.empty());
+    ASSERT_EQUAL(close_ids.size(), static_cast<size_t>(close_count));
+    for (int id = 0; id < close_count; ++id) {
+        ASSERT_EQUAL(close_documents[id].id, id);
+        ASSERT_EQUAL(close_ids[id], id);
+    }
+}
+
+void TestRequestStats() {
+    using namespace std::chrono_literals;
+    RequestStats stats;
+    const RequestStats::Clock::time_point start_time = RequestStats::Clock::time_point() + 24h;
+    stats.Record(3, 1000ns, start_time);
+    stats.Record(0, 3000ns, start_time + 50ms);
+    stats.Record(5, 100us, start_time + 30s);
+
+    // окно секунды к моменту третьего запроса содержит только его
+    const auto second = stats.GetStats(StatsWindow::SECOND, start_time + 30s);
+    ASSERT_EQUAL(second.request_count, 1u);
+    ASSERT_EQUAL(second.result_count, 5u);
+    ASSERT_EQUAL(second.max_latency_ns, 100'000u);
+
+    const auto minute = stats.GetStats(StatsWindow::MINUTE, start_time + 30s);
+    ASSERT_EQUAL(minute.request_count, 3u);
+    ASSERT_EQUAL(minute.result_count, 8u);
+    ASSERT_EQUAL(minute.empty_result_count, 1u);
+    ASSERT(std::abs(minute.empty_result_rate - 1.0 / 3.0) < EPSILON);
+    ASSERT(std::abs(minute.requests_per_second - 3.0 / 60.0) < EPSILON);
+    ASSERT(std::abs(minute.mean_latency_ns - 104'000.0 / 3.0) < EPSILON);
+    ASSERT(minute.p50_latency_ns >= 3000 && minute.p50_latency_ns < 6000);
+    ASSERT_EQUAL(minute.p99_latency_ns, 100'000u);
+
+    // через полторы минуты первые два запроса выходят из окна минуты, но остаются в окне суток
+    ASSERT_EQUAL(stats.GetStats(StatsWindow::MINUTE, start_time + 80s).request_count, 1u);
+    ASSERT_EQUAL(stats.GetStats(StatsWindow::DAY, start_time + 80s).request_count, 3u);
+    ASSERT_EQUAL(stats.GetStats(StatsWindow::DAY, start_time + 25h).request_count, 0u);
+
+    // ячейки переиспользуются по кругу: запрос через сутки не смешивается со старыми
+    stats.Record(1, 1us, start_time + 24h);
+    ASSERT_EQUAL(stats.GetStats(StatsWindow::DAY, start_time + 24h).request_count, 1u);
+
+    // одновременная запись из нескольких потоков, в том числе со сменой ячеек, не теряет запросов
+    RequestStats concurrent_stats;
+    const size_t thread_count = 4;
+    const size_t records_per_thread = 10'000;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&concurrent_stats, start_time, records_per_thread] {
+            for (size_t j = 0; j < records_per_thread; ++j) {
+                concurrent_stats.Record(j % 2, 1us, start_time + std::chrono::milliseconds(j / 1000));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const auto concurrent_second = concurrent_stats.GetStats(StatsWindow::SECOND, start_time + 9ms);
+    ASSERT_EQUAL(concurrent_second.request_count, thread_count * records_per_thread);
+    ASSERT_EQUAL(concurrent_second.empty_result_count, thread_count * records_per_thread / 2);
+
+    // запись в интервал, ячейку которого другой поток уже передал следующему кругу, в новый интервал не попадает
+    RequestStats rotating_stats;
+    threads.clear();
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&rotating_stats, start_time, records_per_thread] {
+            for (size_t j = 0; j < records_per_thread; ++j) {
+                if (j % 2 == 0) {
+                    rotating_stats.Record(0, 1us, start_time);
+                } else {
+                    rotating_stats.Record(1, 1us, start_time + 1s);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const auto rotated_second = rotating_stats.GetStats(StatsWindow::SECOND, start_time + 1s);
+    ASSERT_EQUAL(rotated_second.request_count, thread_count * records_per_thread / 2);
+    ASSERT_EQUAL(rotated_second.empty_result_count, 0u);
+}
+
+void TestRequiredWords() {
+    SearchServer server("and in on"s);
+    server.AddDocument(0, "big white cat"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(1, "big nasty dog"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(2, "small nasty dog"s, DocumentStatus::ACTUAL, { 3 });
+    server.AddDocument(3, "big dog with big collar"s, DocumentStatus::ACTUAL, { 4 });
+    server.AddDocument(4, "big fluffy dog"s, DocumentStatus::BANNED, { 5 });
+    server.AddDocument(5, "big dog in nasty collar"s, DocumentStatus::ACTUAL, { 6 });
+
+    // без обязательных слов найдены все документы с любым из слов
+    ASSERT_EQUAL(server.FindDocumentsPage("big nasty dog"s, 0, 10).documents.size(), 5u);
+
+    const std::string query = "+big nasty +dog -collar"s;
+    const std::vector<int> expected_ids = { 1 };
+    QueryContext context;
+    const auto seq_documents = server.FindTopDocuments(query);
+    const auto par_documents = server.FindTopDocuments(std::execution::par, query);
+    const auto context_documents = server.FindTopDocuments(context, query);
+    ASSERT_EQUAL(seq_documents.size(), expected_ids.size());
+    ASSERT_EQUAL(par_documents.size(), expected_ids.size());
+    ASSERT_EQUAL(context_documents.size(), expected_ids.size());
+    ASSERT_EQUAL(seq_documents[0].id, 1);
+    ASSERT_EQUAL(par_documents[0].id, 1);
+    ASSERT_EQUAL(context_documents[0].id, 1);
+
+    // релевантность считается по всем плюс-словам, как у запроса без обязательных слов
+    const auto disjunctive_documents = server.FindTopDocuments("big nasty dog -collar"s);
+    const auto conjunctive_documents = server.FindTopDocuments("+big +nasty +dog"s);
+    ASSERT_EQUAL(conjunctive_documents.size(), 2u);
+    ASSERT_EQUAL(disjunctive_documents[0].id, 1);
+    ASSERT(std::abs(seq_documents[0].relevance - disjunctive_documents[0].relevance) < EPSILON);
+
+    // проверяются только документы пересечения
+    const auto explanation = server.ExplainTopDocuments("+big +dog"s, DocumentFilter{});
+    ASSERT_EQUAL(explanation.postings_scanned, 4u);
+    ASSERT_EQUAL(explanation.documents.size(), 4u);
+    ASSERT_EQUAL(server.FindTopDocuments("+big +parrot"s).size(), 0u);
+
+    const auto [matched_words, status] = server.MatchDocument("+nasty big"s, 0);
+    ASSERT(matched_words.empty());
+    const auto [par_matched_words, par_status] = server.MatchDocument(std::execution::par, "+nasty big"s, 1);
+    ASSERT_EQUAL(par_matched_words.size(), 2u);
+
+    for (const std::string& invalid_query : { "+"s, "++dog"s, "+-dog"s, "-+dog"s }) {
+        bool rejected = false;
+        try {
+            server.FindTopDocuments(invalid_query);
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        ASSERT_HINT(rejected, "Invalid required word must be rejected"s);
+    }
+}
+
+void TestBatchQueries() {
+    mt19937 generator(7);
+    const auto dictionary = GenerateDictionary(generator, 50, 5);
+    SearchServer server(dictionary[0]);
+    const auto documents = GenerateQueries(generator, dictionary, 300, 10);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        server.AddDocument(i, documents[i], i % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { static_cast<int>(i % 7) });
+    }
+    // короткий словарь даёт много общих слов у запросов
+    auto queries = GenerateQueries(generator, dictionary, 100, 4);
+    for (size_t i = 0; i < queries.size(); i += 3) {
+        queries[i] += " -"s + dictionary[i % dictionary.size()];
+    }
+    queries.push_back("+"s + dictionary[1] + " +"s + dictionary[2] + " "s + dictionary[3]);
+    queries.push_back(dictionary[0]);
+
+    const auto batch_results = ProcessQueriesBatched(server, queries);
+    const auto single_results = ProcessQueries(server, queries);
+    const auto filtered_results = server.FindTopDocumentsBatch(queries, DocumentFilter::ByStatus(DocumentStatus::BANNED));
+    ASSERT_EQUAL(batch_results.size(), queries.size());
+    ASSERT_EQUAL(filtered_results.size(), queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        ASSERT_EQUAL(batch_results[i].size(), single_results[i].size());
+        for (size_t j = 0; j < batch_results[i].size(); ++j) {
+            ASSERT(std::abs(batch_results[i][j].relevance - single_results[i][j].relevance) < EPSILON);
+            ASSERT_EQUAL(batch_results[i][j].rating, single_results[i][j].rating);
+        }
+        const auto expected = server.FindTopDocuments(queries[i], DocumentStatus::BANNED);
+        ASSERT_EQUAL(filtered_results[i].size(), expected.size());
+        for (size_t j = 0; j < expected.size(); ++j) {
+            ASSERT(std::abs(filtered_results[i][j].relevance - expected[j].relevance) < EPSILON);
+        }
+    }
+    // запрос из одного стоп-слова ничего не находит
+    ASSERT(batch_results.back().empty());
+}
+
+void TestChampionLists() {
+    mt19937 generator(11);
+    const auto dictionary = GenerateDictionary(generator, 30, 5);
+    SearchServer server(dictionary[0]);
+    const auto documents = GenerateQueries(generator, dictionary, 600, 6);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        server.AddDocument(i, documents[i], i % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { static_cast<int>(i % 11) });
+    }
+    vector<string> queries;
+    for (size_t i = 1; i < dictionary.size(); ++i) {
+        queries.push_back(dictionary[i]);
+        queries.push_back(dictionary[i] + " "s + dictionary[(i * 7) % dictionary.size()]);
+        queries.push_back(dictionary[i] + " -"s + dictionary[(i * 3) % dictionary.size()]);
+    }
+    // ExplainTopDocuments всегда обходит списки документов целиком
+    const auto check_queries = [&queries](const SearchServer& server) {
+        QueryContext context;
+        const auto rating_filter = [](int, DocumentStatus, int rating) { return rating > 8; };
+        for (const string& query : queries) {
+            const auto check = [&query](const vector<Document>& found, const vector<Document>& expected) {
+                ASSERT_EQUAL_HINT(found.size(), expected.size(), query);
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    ASSERT_HINT(std::abs(found[i].relevance - expected[i].relevance) < EPSILON, query);
+                    ASSERT_EQUAL_HINT(found[i].rating, expected[i].rating, query);
+                }
+            };
+            check(server.FindTopDocuments(query), server.ExplainTopDocuments(query).documents);
+            check(server.FindTopDocuments(context, query), server.ExplainTopDocuments(query).documents);
+            check(server.FindTopDocuments(query, DocumentStatus::BANNED),
+                  server.ExplainTopDocuments(query, DocumentStatus::BANNED).documents);
+            check(server.FindTopDocuments(std::execution::par, query, rating_filter),
+                  server.ExplainTopDocuments(query, rating_filter).documents);
+        }
+    };
+    check_queries(server);
+
+    // удаление лидеров сокращает списки, и они заново набираются из списков документов
+    for (int document_id = 0; document_id < 600; document_id += 3) {
+        server.RemoveDocument(document_id);
+    }
+    for (int document_id = 1; document_id < 600; document_id += 6) {
+        server.RemoveDocument(std::execution::par, document_id);
+    }
+    check_queries(server);
+
+    // с несинхронизированным ресурсом параллельное удаление освобождает узлы из одного потока
+    // и даёт тот же индекс
+    std::pmr::unsynchronized_pool_resource pool;
+    SearchServer pool_server(dictionary[0], &pool);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        pool_server.AddDocument(i, documents[i], i % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { static_cast<int>(i % 11) });
+    }
+    for (int document_id = 0; document_id < 600; ++document_id) {
+        if (document_id % 3 == 0 || document_id % 6 == 1) {
+            pool_server.RemoveDocument(std::execution::par, document_id);
+        }
+    }
+    ASSERT_EQUAL(pool_server.GetDocumentCount(), server.GetDocumentCount());
+    for (const string& query : queries) {
+        const auto found = pool_server.FindTopDocuments(query);
+        const auto expected = server.FindTopDocuments(query);
+        ASSERT_EQUAL_HINT(found.size(), expected.size(), query);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_HINT(std::abs(found[i].relevance - expected[i].relevance) < EPSILON, query);
+            ASSERT_EQUAL_HINT(found[i].rating, expected[i].rating, query);
+        }
+    }
+
+    const auto more_documents = GenerateQueries(generator, dictionary, 200, 3);
+    for (size_t i = 0; i < more_documents.size(); ++i) {
+        server.AddDocument(1000 + i, more_documents[i], DocumentStatus::ACTUAL, { static_cast<int>(i % 13) });
+    }
+    check_queries(server);
+
+#ifndef SEARCH_SERVER_DISABLE_METRICS
+    ResetMetrics();
+    server.FindTopDocuments(dictionary[1]);
+    // Bm25Scoring учитывает длину документа и списками лидеров не пользуется
+    server.FindTopDocuments(dictionary[1], DocumentFilter::ByStatus(DocumentStatus::ACTUAL), Bm25Scoring());
+    const auto metrics = CollectMetrics();
+    ASSERT_EQUAL(metrics.counters[static_cast<size_t>(MetricsCounter::CHAMPION_HITS)]
+                 + metrics.counters[static_cast<size_t>(MetricsCounter::CHAMPION_FALLBACKS)], 1u);
+#endif
+}
+
+void TestWildcardQueries() {
+    ASSERT(MatchesWildcard("ca*"s, "cat"s) && MatchesWildcard("ca*"s, "ca"s) && MatchesWildcard("c*t"s, "cart"s));
+    ASSERT(MatchesWildcard("c*a*t"s, "catapult"s) && !MatchesWildcard("c*t"s, "cats"s) && !MatchesWildcard("ca*"s, "dog"s));
+
+    SearchServer server("and in"s);
+    server.AddDocument(0, "cat and dog"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(1, "cats in catalog"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(2, "cart of dogs"s, DocumentStatus::ACTUAL, { 3 });
+    server.AddDocument(3, "parrot"s, DocumentStatus::ACTUAL, { 4 });
+    server.AddDocument(4, "catfish"s, DocumentStatus::ACTUAL, { 5 });
+    server.RemoveDocument(4);
+
+    const auto found_ids = [&server](const string& query) {
+        vector<int> ids;
+        for (const Document& document : server.FindTopDocuments(query)) {
+            ids.push_back(document.id);
+        }
+        sort(ids.begin(), ids.end());
+        return ids;
+    };
+    ASSERT(found_ids("cat*"s) == vector<int>({ 0, 1 }));
+    ASSERT(found_ids("c*t"s) == vector<int>({ 0, 2 }));
+    ASSERT(found_ids("c* -dog*"s) == vector<int>({ 1 }));
+    ASSERT(found_ids("catf*"s).empty());
+    // документ, содержащий несколько раскрытых слов, получает вклад каждого из них
+    const auto cats = server.FindTopDocuments("cat*"s);
+    ASSERT_EQUAL(cats.front().id, 1);
+
+    const auto [words, status] = server.MatchDocument("cat* parrot"s, 1);
+    ASSERT(words == vector<string_view>({ "catalog"sv, "cats"sv }));
+    const auto [par_words, par_status] = server.MatchDocument(std::execution::par, "dog* -cats*"s, 2);
+    ASSERT(par_words == vector<string_view>({ "dogs"sv }));
+
+    const auto explanation = server.ExplainTopDocuments("ca*"s);
+    // cart, cat, catalog, cats; у catfish после удаления документа список пуст
+    ASSERT_EQUAL(explanation.plus_terms.size(), 4u);
+
+    const auto assert_invalid = [&server](const string& query) {
+        try {
+            server.FindTopDocuments(query);
+            ASSERT_HINT(false, query);
+        } catch (const invalid_argument&) {
+        }
+    };
+    assert_invalid("*at"s);
+    assert_invalid("+cat*"s);
+    SearchServer large_server(""s);
+    for (int i = 0; i < 200; ++i) {
+        large_server.AddDocument(i, "w"s + to_string(i), DocumentStatus::ACTUAL, { 1 });
+    }
+    ASSERT_EQUAL(large_server.FindTopDocuments("w1*"s).size(), 5u);
+    try {
+        large_server.FindTopDocuments("w*"s);
+        ASSERT_HINT(false, "Expansion limit must be enforced"s);
+    } catch (const invalid_argument&) {
+    }
+}
+
+void TestTypoTolerance() {
+    ASSERT_EQUAL(ComputeEditDistance("kitten"s, "sitting"s), 3u);
+    ASSERT_EQUAL(ComputeEditDistance(""s, "cat"s), 3u);
+    ASSERT_EQUAL(ComputeEditDistance("flufy"s, "fluffy"s), 1u);
+
+    SearchServer server("and with"s);
+    server.AddDocument(0, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(2, "well-groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+    server.AddDocument(3, "groomed starling with collar"s, DocumentStatus::ACTUAL, { 9 });
+    server.AddDocument(4, "talking parrot"s, DocumentStatus::ACTUAL, { 1 });
+    server.RemoveDocument(4);
+
+    const auto found_ids = [&server](const string& query) {
+        vector<int> ids;
+        for (const Document& document : server.FindTopDocuments(query)) {
+            ids.push_back(document.id);
+        }
+        sort(ids.begin(), ids.end());
+        return ids;
+    };
+    ASSERT(found_ids("flufy"s) == vector<int>({ 1 }));
+    ASSERT(found_ids("colar"s) == vector<int>({ 0, 3 }));
+    // перестановка соседних букв - две правки, допустимые для слов от 6 символов
+    ASSERT(found_ids("goromed"s) == vector<int>({ 3 }));
+    // слова удалённых документов и короткие слова не исправляются
+    ASSERT(found_ids("parot"s).empty());
+    ASSERT(found_ids("ct"s).empty());
+    // минус-слова и обязательные слова не исправляются
+    ASSERT(found_ids("cat -flufy"s) == vector<int>({ 0, 1 }));
+    ASSERT(found_ids("+colar"s).empty());
+
+    const auto [words, status] = server.MatchDocument("flufy tai"s, 1);
+    ASSERT(words == vector<string_view>({ "fluffy"sv, "tail"sv }));
+
+    server.SetTypoTolerance(false);
+    ASSERT(found_ids("flufy"s).empty());
+    server.SetTypoTolerance(true);
+
+    // исправления совпадают с ближайшими словами словаря, найденными полным перебором
+    mt19937 generator(5);
+    const auto dictionary = GenerateDictionary(generator, 2000, 9);
+    SearchServer random_server(""s);
+    for (size_t i = 0; i < dictionary.size(); ++i) {
+        random_server.AddDocument(i, dictionary[i], DocumentStatus::ACTUAL, { 1 });
+    }
+    const set<string> vocabulary(dictionary.begin(), dictionary.end());
+    for (int i = 0; i < 300; ++i) {
+        string word = dictionary[generator() % dictionary.size()];
+        word.erase(generator() % word.size(), 1);
+        if (!word.empty()) {
+            word[generator() % word.size()] = static_cast<char>('a' + generator() % 26);
+        }
+        if (word.size() < 3 || vocabulary.count(word) > 0) {
+            continue;
+        }
+        const size_t max_distance = word.size() < 6 ? 1 : 2;
+        size_t best_distance = max_distance + 1;
+        for (const string& term : vocabulary) {
+            best_distance = min(best_distance, ComputeEditDistance(word, term));
+        }
+        const auto explanation = random_server.ExplainTopDocuments(word);
+        if (best_distance > max_distance) {
+            ASSERT_EQUAL_HINT(explanation.plus_terms.size(), 1u, word);
+            ASSERT_EQUAL_HINT(explanation.plus_terms.front().word, word, word);
+            continue;
+        }
+        ASSERT_HINT(!explanation.plus_terms.empty(), word);
+        for (const TermExplanation& term : explanation.plus_terms) {
+            ASSERT_EQUAL_HINT(ComputeEditDistance(word, term.word), best_distance, word);
+        }
+    }
+}
+
+void TestSearchBudget() {
+    SearchServer server("and"s);
+    size_t common_count = 0;
+    for (int i = 0; i < 100; ++i) {
+        const string text = i % 10 == 0 ? "rare common"s : i % 7 == 0 ? "other"s : i % 3 == 0 ? "common banned-word"s : "common"s;
+        common_count += text.find("common"s) != string::npos ? 1 : 0;
+        server.AddDocument(i, text, DocumentStatus::ACTUAL, { i });
+    }
+    for (const string& query : { "rare common"s, "rare -banned-word"s, "+rare common"s, "common -rare"s }) {
+        const auto exact = server.FindTopDocuments(query);
+        const auto result = server.FindTopDocumentsWithinBudget(query, SearchBudget{});
+        ASSERT_HINT(!result.is_approximate, query);
+        ASSERT_EQUAL_HINT(result.documents.size(), exact.size(), query);
+        for (size_t i = 0; i < exact.size(); ++i) {
+            ASSERT_EQUAL_HINT(result.documents[i].id, exact[i].id, query);
+            ASSERT_HINT(std::abs(result.documents[i].relevance - exact[i].relevance) < EPSILON, query);
+        }
+    }
+
+    // бюджета хватает только на список редкого слова: его документы найдены с неполной релевантностью
+    SearchBudget budget;
+    budget.max_postings = 10;
+    const auto partial = server.FindTopDocumentsWithinBudget("common rare"s, budget);
+    ASSERT(partial.is_approximate);
+    ASSERT_EQUAL(partial.postings_scanned, 10u);
+    ASSERT_EQUAL(partial.documents.size(), 5u);
+    const auto exact = server.FindTopDocuments("common rare"s);
+    for (size_t i = 0; i < partial.documents.size(); ++i) {
+        ASSERT_EQUAL(partial.documents[i].id % 10, 0);
+        ASSERT_EQUAL(partial.documents[i].id, exact[i].id);
+        ASSERT(partial.documents[i].relevance < exact[i].relevance);
+    }
+    // бюджет, точно равный суммарной длине списков, не делает выдачу приблизительной
+    budget.max_postings = 10 + common_count;
+    ASSERT(!server.FindTopDocumentsWithinBudget("common rare"s, budget).is_approximate);
+
+    SearchBudget time_budget;
+    time_budget.time_limit = std::chrono::nanoseconds(1);
+    const auto timed_out = server.FindTopDocumentsWithinBudget("common"s, time_budget, DocumentStatus::ACTUAL);
+    ASSERT(timed_out.is_approximate);
+    ASSERT(timed_out.postings_scanned < common_count);
+}
+
+void TestImpactIndex() {
+    mt19937 generator(3);
+    const auto dictionary = GenerateDictionary(generator, 300, 8);
+    SearchServer server(dictionary[0]);
+    const auto documents = GenerateQueries(generator, dictionary, 2000, 12);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        server.AddDocument(i, documents[i], i % 6 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { static_cast<int>(i % 17) });
+    }
+    server.RemoveDocument(7);
+    const ImpactIndex index(server);
+    ASSERT(index.GetQuantizationStep() > 0.0);
+    ASSERT(index.GetMemoryBytes() < server.GetIndexStats().postings_bytes);
+
+    for (int i = 0; i < 200; ++i) {
+        const string query = GenerateQuery(generator, dictionary, 1 + i % 4, 0.2);
+        // полная точная выдача даёт точную релевантность любого найденного документа
+        const auto exact = server.FindDocumentsPage(query, 0, documents.size());
+        map<int, double> exact_relevance;
+        for (const Document& document : exact.documents) {
+            exact_relevance[document.id] = document.relevance;
+        }
+        const double bound = index.GetQuantizationStep() * (1 + i % 4) + EPSILON;
+        const auto found = index.FindTopDocuments(query);
+        ASSERT_EQUAL_HINT(found.size(), min(exact.documents.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT)), query);
+        for (const Document& document : found) {
+            ASSERT_HINT(exact_relevance.count(document.id) > 0, query);
+            ASSERT_HINT(std::abs(document.relevance - exact_relevance.at(document.id)) <= bound, query);
+            // документ, вытеснивший более релевантный, отстаёт от него не больше чем на две границы
+            ASSERT_HINT(exact_relevance.at(document.id) >= exact.documents[found.size() - 1].relevance - 2 * bound, query);
+        }
+    }
+
+    const auto banned = index.FindTopDocuments(dictionary[1] + " "s + dictionary[2], DocumentStatus::BANNED);
+    ASSERT(!banned.empty());
+    for (const Document& document : banned) {
+        ASSERT_EQUAL(document.id % 6, 0);
+    }
+    const auto high_rating = index.FindTopDocuments(dictionary[1], [](int, DocumentStatus, int rating) { return rating > 14; });
+    for (const Document& document : high_rating) {
+        ASSERT(document.rating > 14);
+    }
+    for (const Document& document : index.FindTopDocuments(dictionary[1] + " -"s + dictionary[2])) {
+        ASSERT(server.GetWordFrequencies(document.id).count(dictionary[2]) == 0);
+    }
+
+    // снимок не меняется вместе с сервером
+    server.AddDocument(5000, "brand-new-word"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT(index.FindTopDocuments("brand-new-word"s).empty());
+    try {
+        index.FindTopDocuments("+"s + dictionary[1]);
+        ASSERT_HINT(false, "Required words are not supported by the impact index"s);
+    } catch (const invalid_argument&) {
+    }
+
+    QueryContext context;
+    const string query = dictionary[1] + " "s + dictionary[3] + " -"s + dictionary[4];
+    index.FindTopDocuments(context, query);
+    const size_t allocations_before = GetAllocationCount();
+    for (int i = 0; i < 50; ++i) {
+        index.FindTopDocuments(context, query);
+    }
+    const size_t allocations_after = GetAllocationCount();
+    ASSERT_EQUAL(allocations_after - allocations_before, 0u);
+}
+
+void TestDocumentStore() {
+    mt19937 generator(5);
+    // блоки с длинными повторами (совпадения, перекрывающиеся сами с собой), случайными байтами и пустой блок
+    vector<string> blocks = { ""s, "a"s, "abcd"s, string(1000, 'x'), "cat dog cat dog cat dog cat dog parrot"s };
+    string random_bytes;
+    for (int i = 0; i < 70'000; ++i) {
+        random_bytes += static_cast<char>(uniform_int_distribution(0, 255)(generator));
+    }
+    blocks.push_back(random_bytes);
+    const auto dictionary = GenerateDictionary(generator, 200, 8);
+    string words;
+    for (const string& document : GenerateQueries(generator, dictionary, 2000, 20)) {
+        words += document + " "s;
+    }
+    blocks.push_back(words);
+    for (const string& block : blocks) {
+        ASSERT(DecompressBlock(CompressBlock(block), block.size()) == block);
+    }
+    ASSERT(CompressBlock(words).size() < words.size() / 2);
+
+    // маленькие блоки и кеш на два блока: тексты читаются и из открытого блока, и из сжатых
+    DocumentStore store(256, 2);
+    const auto documents = GenerateQueries(generator, dictionary, 500, 20);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        store.Add(i, documents[i]);
+    }
+    for (size_t i = 0; i < documents.size(); i += 7) {
+        store.Remove(i);
+    }
+    for (size_t i = documents.size(); i-- > 0;) {
+        if (i % 7 == 0) {
+            ASSERT(!store.Contains(i));
+        } else {
+            ASSERT_EQUAL(store.GetText(i), documents[i]);
+        }
+    }
+    try {
+        store.GetText(0);
+        ASSERT_HINT(false, "Removed document text must not be available"s);
+    } catch (const out_of_range&) {
+    }
+    DocumentStore copy = store;
+    ASSERT_EQUAL(copy.GetText(1), documents[1]);
+    ASSERT_EQUAL(copy.GetTextBytes(), store.GetTextBytes());
+    // большой id не раздувает таблицу расположений текстов
+    const size_t memory_bytes = store.GetMemoryBytes();
+    store.Add(2'000'000'000, "cat"s);
+    ASSERT_EQUAL(store.GetText(2'000'000'000), "cat"s);
+    ASSERT(store.GetMemoryBytes() < memory_bytes + 1024);
+    store.Remove(2'000'000'000);
+    ASSERT(!store.Contains(2'000'000'000));
+
+    SearchServer server("and in on"s);
+    try {
+        server.GetDocumentText(1);
+        ASSERT_HINT(false, "Document store is disabled by default"s);
+    } catch (const logic_error&) {
+    }
+    server.EnableDocumentStore();
+    server.AddDocument(1, "white cat and fashionable collar in the big city on a sunny day near the old river"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT_EQUAL(server.GetDocumentText(2), "fluffy cat fluffy tail"s);
+
+    SnippetOptions options;
+    options.fragment_word_count = 4;
+    options.highlight_begin = "["s;
+    options.highlight_end = "]"s;
+    auto snippets = server.GetSnippets("cat river"s, 1, options);
+    ASSERT_EQUAL(snippets.size(), 2u);
+    ASSERT_EQUAL(snippets[0], "white [cat] and fashionable"s);
+    ASSERT_EQUAL(snippets[1], "near the old [river]"s);
+    // слово, найденное по опечатке, выделяется в тексте
+    snippets = server.GetSnippets("fluffi"s, 2, options);
+    ASSERT_EQUAL(snippets.size(), 1u);
+    ASSERT_EQUAL(snippets[0], "[fluffy] cat [fluffy] tail"s);
+    // документ, не соответствующий запросу, представлен началом текста
+    snippets = server.GetSnippets("dog"s, 1, options);
+    ASSERT_EQUAL(snippets.size(), 1u);
+    ASSERT_EQUAL(snippets[0], "white cat and fashionable"s);
+
+    const IndexStats stats = server.GetIndexStats();
+    ASSERT_EQUAL(stats.document_text_bytes, 104u);
+    server.RemoveDocument(2);
+    ASSERT_EQUAL(server.GetIndexStats().document_text_bytes, 82u);
+    try {
+        server.EnableDocumentStore();
+        ASSERT_HINT(false, "Document store can only be enabled on an empty server"s);
+    } catch (const logic_error&) {
+    }
+}
+
+void TestConcurrentMap() {
+    const int thread_count = 4;
+    const int key_count = 1000;
+    // один сегмент с минимальной таблицей: ключи расходятся по цепочке таблиц
+    ConcurrentMap<int, int> counters(1);
+    ConcurrentMap<string, double> weights(3);
+    ConcurrentMap<int, vector<int>> lists(2, key_count);
+    vector<thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < key_count; ++i) {
+                const int key = (i * 7 + t * 13) % key_count - key_count / 2;
+                counters.FetchAdd(key, 1);
+                counters[key].ref_to_value += 2;
+                weights.FetchAdd("key-"s + to_string(i % 100), 0.5);
+                lists[i].ref_to_value.push_back(t);
+            }
+        });
+    }
+    for (thread& thread : threads) {
+        thread.join();
+    }
+
+    const auto ordinary_counters = counters.BuildOrdinaryMap();
+    ASSERT_EQUAL(ordinary_counters.size(), static_cast<size_t>(key_count));
+    ASSERT_EQUAL(ordinary_counters.begin()->first, -key_count / 2);
+    for (const auto& [key, value] : ordinary_counters) {
+        ASSERT_EQUAL_HINT(value, 3 * thread_count, to_string(key));
+    }
+    size_t weight_count = 0;
+    weights.ForEach([&weight_count](const string& key, double value) {
+        ++weight_count;
+        ASSERT_EQUAL_HINT(value, 0.5 * thread_count * key_count / 100, key);
+    });
+    ASSERT_EQUAL(weight_count, 100u);
+    lists.ForEach([](int key, const vector<int>& value) {
+        ASSERT_EQUAL_HINT(value.size(), static_cast<size_t>(thread_count), to_string(key));
+    });
+
+    // удалённый ключ не виден при обходе и появляется снова с новым значением
+    counters.Erase(-1);
+    counters.Erase(key_count * 10);
+    ASSERT_EQUAL(counters.BuildOrdinaryMap().count(-1), 0u);
+    ASSERT_EQUAL(counters.FetchAdd(-1, 5), 0);
+    ASSERT_EQUAL(counters.BuildOrdinaryMap().at(-1), 5);
+    lists.Erase(3);
+    ASSERT(lists[3].ref_to_value.empty());
+
+    // вставки и удаления всё новых ключей не раздувают таблицы: удалённые ячейки освобождаются перестройкой
+    // сегмента, а значения живых ключей при ней сохраняются
+    const int churn_count = 50'000;
+    ConcurrentMap<int, int> churn(2);
+    threads.clear();
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&churn, t, churn_count] {
+            for (int i = 0; i < churn_count; ++i) {
+                const int key = (t + 1) * churn_count + i;
+                churn.FetchAdd(key, 1);
+                churn.FetchAdd(-1 - t, 1);
+                churn.Erase(key);
+            }
+        });
+    }
+    for (thread& thread : threads) {
+        thread.join();
+    }
+    // перестройка, пропущенная из-за занятого сегмента, выполняется при следующих удалениях
+    for (int i = 0; i < churn_count; ++i) {
+        churn.FetchAdd(i, 1);
+        churn.Erase(i);
+    }
+    ASSERT_EQUAL(churn.GetSize(), static_cast<size_t>(thread_count));
+    ASSERT(churn.GetCapacity() <= 256u);
+    const auto churn_counters = churn.BuildOrdinaryMap();
+    ASSERT_EQUAL(churn_counters.size(), static_cast<size_t>(thread_count));
+    for (const auto& [key, value] : churn_counters) {
+        ASSERT_EQUAL_HINT(value, churn_count, to_string(key));
+    }
+}
+
+void TestPreparedQuery() {
+    mt19937 generator(13);
+    const auto dictionary = GenerateDictionary(generator, 40, 5);
+    SearchServer server(dictionary[0]);
+    const auto documents = GenerateQueries(generator, dictionary, 400, 8);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        server.AddDocument(i, documents[i], i % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { static_cast<int>(i % 9) });
+    }
+    auto queries = GenerateQueries(generator, dictionary, 60, 4);
+    for (size_t i = 0; i < queries.size(); i += 3) {
+        queries[i] += " -"s + dictionary[i % dictionary.size()];
+    }
+    queries.push_back("+"s + dictionary[1] + " +"s + dictionary[2] + " "s + dictionary[3]);
+    queries.push_back("+missing "s + dictionary[1]);
+    queries.push_back(dictionary[1] + " missing -absent"s);
+
+    const auto same_documents = [](const vector<Document>& lhs, const vector<Document>& rhs) {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            if (lhs[i].id != rhs[i].id || std::abs(lhs[i].relevance - rhs[i].relevance) >= EPSILON) {
+                return false;
+            }
+        }
+        return true;
+    };
+    const auto check_queries = [&](const SearchServer& search_server, vector<PreparedQuery>& prepared_queries) {
+        // выдача сравнивается с запросом-строкой через контекст: порядок документов с равными релевантностью
+        // и рейтингом там выбирается так же
+        QueryContext context;
+        QueryContext raw_query_context;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            ASSERT(same_documents(search_server.FindTopDocuments(prepared_queries[i]),
+                                  search_server.FindTopDocuments(raw_query_context, queries[i])));
+            ASSERT(same_documents(search_server.FindTopDocuments(context, prepared_queries[i], DocumentStatus::BANNED),
+                                  search_server.FindTopDocuments(raw_query_context, queries[i], DocumentStatus::BANNED)));
+            const auto even_rating = [](int, DocumentStatus, int rating) { return rating % 2 == 0; };
+            ASSERT(same_documents(search_server.FindTopDocuments(context, prepared_queries[i], even_rating, Bm25Scoring()),
+                                  search_server.FindTopDocuments(raw_query_context, queries[i], even_rating, Bm25Scoring())));
+            for (const int document_id : search_server) {
+                ASSERT(search_server.MatchDocument(prepared_queries[i], document_id)
+                       == search_server.MatchDocument(queries[i], document_id));
+            }
+        }
+    };
+
+    vector<PreparedQuery> prepared_queries;
+    for (const string& query : queries) {
+        prepared_queries.push_back(server.PrepareQuery(query));
+    }
+    ASSERT_EQUAL(prepared_queries[0].GetRawQuery(), queries[0]);
+    check_queries(server, prepared_queries);
+    ASSERT(server.FindTopDocuments(prepared_queries[queries.size() - 2]).empty());
+
+    // подготовленные запросы подготавливаются заново после добавления и удаления документов
+    server.AddDocument(1000, "missing "s + dictionary[1] + " "s + dictionary[2], DocumentStatus::ACTUAL, { 5 });
+    for (int document_id = 0; document_id < 400; document_id += 3) {
+        server.RemoveDocument(document_id);
+    }
+    check_queries(server, prepared_queries);
+    ASSERT(!server.FindTopDocuments(prepared_queries[queries.size() - 2]).empty());
+
+    // копия сервера выполняет запросы, подготовленные исходным сервером
+    SearchServer copy = server;
+    server.RemoveDocument(1000);
+    check_queries(copy, prepared_queries);
+    check_queries(server, prepared_queries);
+}
+
+void TestPhraseQueries() {
+    {
+        SearchServer server("the of"s);
+        server.EnablePositionalIndex();
+        server.AddDocument(0, "yellow hat on the cat"s, DocumentStatus::ACTUAL, { 1 });
+        server.AddDocument(1, "hat yellow"s, DocumentStatus::ACTUAL, { 2 });
+        server.AddDocument(2, "yellow big hat"s, DocumentStatus::ACTUAL, { 3 });
+        server.AddDocument(3, "yellow the hat"s, DocumentStatus::ACTUAL, { 4 });
+        server.AddDocument(4, "big yellow hat yellow"s, DocumentStatus::ACTUAL, { 5 });
+        const auto find_ids = [&server](const string& query) {
+            set<int> ids;
+            for (const Document& document : server.FindTopDocuments(query)) {
+                ids.insert(document.id);
+            }
+            return ids;
+        };
+        ASSERT(find_ids("\"yellow hat\""s) == set<int>({ 0, 4 }));
+        ASSERT(find_ids("\"hat yellow\""s) == set<int>({ 1, 4 }));
+        // стоп-слово фразы занимает место любого слова
+        ASSERT(find_ids("\"yellow the hat\""s) == set<int>({ 2, 3 }));
+        ASSERT(find_ids("\"yellow hat\"~1"s) == set<int>({ 0, 2, 3, 4 }));
+        ASSERT(find_ids("\"yellow hat\" -big"s) == set<int>({ 0 }));
+        ASSERT(find_ids("\"yellow hat\" \"hat yellow\""s) == set<int>({ 4 }));
+        ASSERT(find_ids("\"big hat\"~1 cat"s) == set<int>({ 2, 4 }));
+        // фраза из одного слова - обязательное слово
+        ASSERT(find_ids("\"big\" cat"s) == set<int>({ 2, 4 }));
+        ASSERT(find_ids("\"yellow cat\""s).empty());
+        ASSERT(find_ids("\"yellow parrot\""s).empty());
+
+        // найденные слова - представления слов запроса
+        const string phrase_query = "\"yellow hat\""s;
+        const auto [words, status] = server.MatchDocument(phrase_query, 0);
+        ASSERT(words == vector<string_view>({ "hat"sv, "yellow"sv }));
+        ASSERT(get<0>(server.MatchDocument(phrase_query, 1)).empty());
+        ASSERT(get<0>(server.MatchDocument(std::execution::par, phrase_query, 1)).empty());
+        ASSERT(get<0>(server.MatchDocument(std::execution::par, phrase_query, 0)) == words);
+        auto prepared_query = server.PrepareQuery("\"yellow hat\" cat"s);
+        ASSERT_EQUAL(server.FindTopDocuments(prepared_query).size(), 2u);
+        ASSERT(get<0>(server.MatchDocument(prepared_query, 2)).empty());
+
+        for (const string& query : { "\"yellow hat"s, "-\"yellow hat\""s, "\"yellow hat\"~"s, "\"yellow hat\"~x"s,
+                                     "\"yellow hat\"1"s, "\"yel* hat\""s, "\"yellow -hat\""s }) {
+            try {
+                server.FindTopDocuments(query);
+                ASSERT_HINT(false, "Invalid phrase query must be rejected: "s + query);
+            } catch (const invalid_argument&) {
+            }
+        }
+        try {
+            server.EnablePositionalIndex();
+            ASSERT_HINT(false, "Positional index must be enabled before adding documents"s);
+        } catch (const logic_error&) {
+        }
+        SearchServer plain_server("the"s);
+        plain_server.AddDocument(0, "yellow hat"s, DocumentStatus::ACTUAL, { 1 });
+        try {
+            plain_server.FindTopDocuments("\"yellow hat\""s);
+            ASSERT_HINT(false, "Phrase queries require the positional index"s);
+        } catch (const logic_error&) {
+        }
+    }
+
+    // выдача фразовых запросов совпадает с прямой проверкой текстов, в том числе после удаления документов
+    mt19937 generator(17);
+    const auto dictionary = GenerateDictionary(generator, 12, 3);
+    SearchServer server(dictionary[0]);
+    server.EnablePositionalIndex();
+    const auto documents = GenerateQueries(generator, dictionary, 300, 12);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { static_cast<int>(i % 7) });
+    }
+    for (int document_id = 0; document_id < 300; document_id += 4) {
+        server.RemoveDocument(document_id);
+    }
+    server.RemoveDocument(std::execution::par, 1);
+
+    // вхождение слов фразы: на тех же расстояниях или по порядку с не больше чем slop лишними словами
+    const auto contains_phrase = [&](const vector<string_view>& text, const vector<string>& phrase, uint32_t slop) {
+        for (size_t start = 0; start < text.size(); ++start) {
+            if (text[start] != phrase[0]) {
+                continue;
+            }
+            size_t position = start;
+            bool is_matched = true;
+            for (size_t i = 1; i < phrase.size() && is_matched; ++i) {
+                // стоп-слово фразы только удлиняет её
+                if (phrase[i] == dictionary[0]) {
+                    continue;
+                }
+                if (slop == 0) {
+                    is_matched = start + i < text.size() && text[start + i] == phrase[i];
+                    position = start + i;
+                } else {
+                    ++position;
+                    while (position < text.size() && text[position] != phrase[i]) {
+                        ++position;
+                    }
+                    is_matched = position < text.size();
+                }
+            }
+            if (is_matched && position - start <= phrase.size() - 1 + slop) {
+                return true;
+            }
+        }
+        return false;
+    };
+    QueryContext context;
+    for (int query_index = 0; query_index < 200; ++query_index) {
+        // фраза из 2-3 слов, часть из которых - слова документа, чтобы фразы находились
+        const string& source = documents[uniform_int_distribution<size_t>(0, documents.size() - 1)(generator)];
+        const auto source_words = SplitIntoWords(source);
+        const size_t phrase_length = uniform_int_distribution<size_t>(2, 3)(generator);
+        if (source_words.size() < phrase_length + 1) {
+            continue;
+        }
+        const size_t start = uniform_int_distribution<size_t>(0, source_words.size() - phrase_length)(generator);
+        vector<string> phrase;
+        for (size_t i = 0; i < phrase_length; ++i) {
+            phrase.push_back(query_index % 3 == 0 ? dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)]
+                                                  : string(source_words[start + i]));
+        }
+        if (phrase.front() == dictionary[0] || phrase.back() == dictionary[0]) {
+            continue;
+        }
+        const uint32_t slop = query_index % 2 == 0 ? 0 : query_index % 5;
+        string query = "\""s;
+        for (const string& word : phrase) {
+            query += word + (&word == &phrase.back() ? "\""s : " "s);
+        }
+        if (slop != 0) {
+            query += "~"s + to_string(slop);
+        }
+
+        set<int> expected_ids;
+        for (const int document_id : server) {
+            if (contains_phrase(SplitIntoWords(documents[document_id]), phrase, slop)) {
+                expected_ids.insert(document_id);
+            }
+            ASSERT_EQUAL(!get<0>(server.MatchDocument(query, document_id)).empty(), expected_ids.count(document_id) > 0);
+            ASSERT_EQUAL(!get<0>(server.MatchDocument(std::execution::par, query, document_id)).empty(),
+                         expected_ids.count(document_id) > 0);
+        }
+        const auto check_documents = [&](const vector<Document>& found_documents) {
+            ASSERT_EQUAL(found_documents.size(), min(expected_ids.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT)));
+            for (const Document& document : found_documents) {
+                ASSERT(expected_ids.count(document.id) > 0);
+            }
+        };
+        check_documents(server.FindTopDocuments(query));
+        check_documents(server.FindTopDocuments(std::execution::par, query));
+        check_documents(server.FindTopDocuments(context, query));
+        auto prepared_query = server.PrepareQuery(query);
+        check_documents(server.FindTopDocuments(context, prepared_query));
+        check_documents(server.FindTopDocumentsWithinBudget(query, SearchBudget{}).documents);
+    }
+}
+
 void Benchmark() {
     mt19937 generator;
     const auto dictionary = GenerateDictionary(generator, 1000, 10);
@@ -208,5 +1556,25 @@ void TestSearchServer() {
     RUN_TEST(TestCalcAndSortInDescOrder);
     RUN_TEST(TestCalculateRatingOfAddedDocumentContent);
     RUN_TEST(TestFilteringResultsByUserDefinedPredicate);
+    RUN_TEST(TestQueryContextSearchIsAllocationFree);
+    RUN_TEST(TestIndexStats);
+    RUN_TEST(TestRoaringBitmap);
+    RUN_TEST(TestFilteringResultsByDocumentFilter);
+    RUN_TEST(TestScoringPolicies);
+    RUN_TEST(TestMetrics);
+    RUN_TEST(TestExplainTopDocuments);
+    RUN_TEST(TestDeepPagination);
+    RUN_TEST(TestRequestStats);
+    RUN_TEST(TestRequiredWords);
+    RUN_TEST(TestBatchQueries);
+    RUN_TEST(TestChampionLists);
+    RUN_TEST(TestWildcardQueries);
+    RUN_TEST(TestTypoTolerance);
+    RUN_TEST(TestSearchBudget);
+    RUN_TEST(TestImpactIndex);
+    RUN_TEST(TestDocumentStore);
+    RUN_TEST(TestConcurrentMap);
+    RUN_TEST(TestPreparedQuery);
+    RUN_TEST(TestPhraseQueries);
     RUN_TEST(Benchmark);
 }
\ No newline at end of file
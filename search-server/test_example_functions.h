@@ -87,6 +87,79 @@ void TestCalculateRatingOfAddedDocumentContent();
 // Тест №6 также проверяет нахождение документов в соответствии с заданным статусом
 void TestFilteringResultsByUserDefinedPredicate();
 
+// Тест №7 проверяет, что поиск с переиспользуемым контекстом запроса даёт ту же выдачу,
+// что и обычный поиск, и после прогрева не выделяет динамическую память
+void TestQueryContextSearchIsAllocationFree();
+
+// Тест №8 проверяет статистику индекса: число слов, списков документов, гистограмму их длин и оценку памяти
+void TestIndexStats();
+
+// Тест №9 проверяет операции сжатой битовой карты, включая переходы между массивом и битовой картой
+// и выделение памяти только из заданного ресурса
+void TestRoaringBitmap();
+
+// Тест №10 проверяет, что декларативный фильтр документов даёт ту же выдачу, что и эквивалентный предикат,
+// в том числе с отрицательными границами диапазона id
+void TestFilteringResultsByDocumentFilter();
+
+// Тест №11 проверяет ранжирование по BM25 и совпадение явно выбранной политики TF-IDF с поведением по умолчанию
+void TestScoringPolicies();
+
+// Тест №12 проверяет границы корзин гистограммы задержек и учёт этапов и счётчиков при поиске
+void TestMetrics();
+
+// Тест №13 проверяет сведения о словах и счётчики разбора запроса и совпадение его выдачи с FindTopDocuments
+void TestExplainTopDocuments();
+
+// Тест №14 проверяет, что постраничная выдача по смещению, по курсору и через ленивый пагинатор
+// совпадает с полностью упорядоченной выдачей, в том числе для близких релевантностей на границе страниц
+void TestDeepPagination();
+
+// Тест №15 проверяет скользящие окна статистики запросов и запись из нескольких потоков
+void TestRequestStats();
+
+// Тест №16 проверяет обязательные слова запроса (+слово): выдача ограничена пересечением их списков документов
+void TestRequiredWords();
+
+// Тест №17 проверяет, что пакетное выполнение запросов с общими словами даёт ту же выдачу, что и поштучное
+void TestBatchQueries();
+
+// Тест №18 проверяет, что выдача коротких запросов по спискам лидеров совпадает с полным обходом,
+// в том числе после удаления и добавления документов и после параллельного удаления с ресурсом памяти
+void TestChampionLists();
+
+// Тест №19 проверяет раскрытие шаблонов со '*' в плюс- и минус-словах запроса и ограничения на шаблоны
+void TestWildcardQueries();
+
+// Тест №20 проверяет исправление опечаток в плюс-словах запроса и совпадение кандидатов
+// из индекса триграмм с ближайшими словами полного перебора словаря
+void TestTypoTolerance();
+
+// Тест №21 проверяет выполнение запроса с бюджетом: без ограничений выдача совпадает с FindTopDocuments,
+// а при исчерпании бюджета первыми обходятся самые редкие слова и выдача помечается приблизительной
+void TestSearchBudget();
+
+// Тест №22 проверяет, что выдача снимка с квантованными вкладами отклоняется от точной
+// не больше объявленной границы, а также фильтры, минус-слова и независимость снимка от сервера
+void TestImpactIndex();
+
+// Тест №23 проверяет сжатие и распаковку блоков, хранение и удаление текстов документов
+// и фрагменты с выделенными словами запроса
+void TestDocumentStore();
+
+// Тест №24 проверяет ConcurrentMap: параллельные FetchAdd и доступ к нечисловым значениям
+// с целыми (в том числе отрицательными) и строковыми ключами, наращивание таблиц, удаление и обход,
+// освобождение удалённых ячеек при вставках и удалениях всё новых ключей
+void TestConcurrentMap();
+
+// Тест №25 проверяет, что подготовленный запрос находит те же документы и слова, что и запрос-строка,
+// в том числе после изменения индекса, с фильтрами и на копии сервера
+void TestPreparedQuery();
+
+// Тест №26 проверяет фразовые запросы: точные фразы, стоп-слова внутри фразы, фразы с ~N,
+// ошибки разбора и совпадение выдачи с прямой проверкой текстов после удаления документов
+void TestPhraseQueries();
+
 // Бенчмарк для измерения времени работы методов
 void Benchmark();
 